@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include "fltklayout.h"
+
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+
+namespace fltklayout {
+
+// group that positions its children from per widget anchors and min/max sizes (see WidgetInfo)
+// instead of FLTK's proportional init_sizes() model.
+// each child keeps its margins to the group edges as captured from its geometry, so repeated
+// resizes are solved from the same integers and never drift
+class AnchorGroup : public Fl_Group {
+    struct Constraint {
+        Fl_Widget *o;
+        int anchor;
+        int min_w,min_h,max_w,max_h;
+        int left,right,top,bottom;      // margins to group edges when captured
+        int w,h;                        // size when captured
+        int sx,sy,sw,sh;                // geometry last set by solve(), if different the child was moved => recapture
+    };
+    std::vector<Constraint> constraints; // same order as children
+
+    void capture(Constraint &c,Fl_Widget *o) {
+        c.o=o;
+        c.anchor=WidgetInfo::ANCHOR_LEFT|WidgetInfo::ANCHOR_TOP;
+        c.min_w=c.min_h=c.max_w=c.max_h=0;
+        WidgetInfo *info=widgets ? widgets->get_info(o) : NULL;
+        if (info) {
+            if (info->anchor) c.anchor=info->anchor;
+            else if (resizable()==o) c.anchor=WidgetInfo::ANCHOR_ALL;
+            c.min_w=info->min_w; c.min_h=info->min_h;
+            c.max_w=info->max_w; c.max_h=info->max_h;
+        } else if (resizable()==o)
+            c.anchor=WidgetInfo::ANCHOR_ALL;
+        c.left=o->x()-x(); c.right=x()+w()-(o->x()+o->w());
+        c.top=o->y()-y();  c.bottom=y()+h()-(o->y()+o->h());
+        c.w=o->w(); c.h=o->h();
+        c.sx=o->x(); c.sy=o->y(); c.sw=o->w(); c.sh=o->h();
+    }
+
+    static void solve_axis(int anchor_lo,int anchor_hi,int pos,int size,int lo,int hi,int csize,int min_size,int max_size,int &out_pos,int &out_size) {
+        out_size= anchor_lo && anchor_hi ? size-lo-hi : csize;
+        if (max_size>0 && out_size>max_size) out_size=max_size;
+        if (out_size<min_size) out_size=min_size;
+        if (out_size<0) out_size=0;
+
+        if (anchor_lo)
+            out_pos=pos+lo;
+        else if (anchor_hi)
+            out_pos=pos+size-hi-out_size;
+        else { // floating => keep the ratio of the free space on each side
+            const int free_space=lo+hi;
+            out_pos=pos+(free_space>0 ? (int)((long long)(size-out_size)*lo/free_space) : (size-out_size)/2);
+        }
+    }
+
+    void solve(Constraint &c) {
+        int X,Y,W,H;
+        solve_axis(c.anchor&WidgetInfo::ANCHOR_LEFT,c.anchor&WidgetInfo::ANCHOR_RIGHT,x(),w(),c.left,c.right,c.w,c.min_w,c.max_w,X,W);
+        solve_axis(c.anchor&WidgetInfo::ANCHOR_TOP,c.anchor&WidgetInfo::ANCHOR_BOTTOM,y(),h(),c.top,c.bottom,c.h,c.min_h,c.max_h,Y,H);
+        if (X!=c.o->x() || Y!=c.o->y() || W!=c.o->w() || H!=c.o->h())
+            c.o->resize(X,Y,W,H);
+        c.sx=X; c.sy=Y; c.sw=W; c.sh=H;
+    }
+
+    void sync() { // pick up added/removed/moved children using the current group bounds
+        if ((int)constraints.size()!=children()) {
+            constraints.resize(children());
+            for (int i=0;i<children();i++)
+                capture(constraints[i],child(i));
+            return;
+        }
+        for (int i=0;i<children();i++) {
+            Constraint &c=constraints[i];
+            Fl_Widget *o=child(i);
+            if (c.o!=o || c.sx!=o->x() || c.sy!=o->y() || c.sw!=o->w() || c.sh!=o->h())
+                capture(c,o);
+        }
+    }
+
+public:
+    Widgets *widgets=nullptr; // collection holding the children's WidgetInfo (anchors,min/max)
+
+    AnchorGroup(int X,int Y,int W,int H,const char *L=0) : Fl_Group(X,Y,W,H,L) { }
+    virtual ~AnchorGroup() { }
+
+    virtual void resize(int X,int Y,int W,int H) {
+        sync();
+        Fl_Widget::resize(X,Y,W,H);
+        for (auto &c : constraints)
+            solve(c);
+        redraw();
+    }
+
+    void invalidate(Fl_Widget *o) { // anchors or limits of one child changed => re-solve just that child
+        int i=find(o);
+        if (i>=children()) return;
+        if ((int)constraints.size()!=children()) { sync(); return; }
+        capture(constraints[i],o);
+        solve(constraints[i]);
+        redraw();
+    }
+};
+
+} // namespace fltklayout
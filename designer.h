@@ -356,6 +356,7 @@ public:
                     g=primary->as_group();
                 g->add(o);
                 g->end();
+                widgets.children_changed(g);
                 action_end();
                 need_redraw_overlay=true;
             }
@@ -447,8 +448,12 @@ public:
         } else if (path=="Selection/Delete/Delete") {
             action_start(ACTION_POPUP_SELECTION_DELETE,tab);
             remove_children(selected);
-            for (auto &o : selected) 
+            std::set<Fl_Widget*> parents;
+            for (auto &o : selected) {
+                parents.insert(o->parent());
                 delete o;
+            }
+            for (auto &g : parents) widgets.children_changed(g);
             clear_selection();
             action_end();
         } else if (path=="Layout/Add New") {
@@ -698,7 +703,11 @@ public:
                    out+=widgets.get_properties(o).serialize()+"\n";
                    for (auto &o : kids)
                        out+=widgets.get_properties(o).serialize()+"\n";
-                   if (is_cut) delete o;
+                   if (is_cut) {
+                       Fl_Widget *g=o->parent();
+                       delete o;
+                       widgets.children_changed(g);
+                   }
                }
                Fl::copy(out.data(),out.size(),1);
                if (is_cut) {
@@ -763,6 +772,7 @@ public:
                 Fl_Widget *o=f->create(&widgets,name,x,y,w,h,label);
                 g->add(o);
                 g->end();
+                widgets.children_changed(g);
 
                 const static std::set<std::string> ignore{ "layout","factory","name","x","y","w","h","label" };
                 props["parent"]=namemap[props["parent"]];
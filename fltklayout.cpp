@@ -11,6 +11,7 @@
 #include <FL/Fl_File_Chooser.H>
 //#include <FL/Fl_Native_File_Chooser.H>
 #include <FL/Fl_Input.H>
+#include <FL/Fl_Input_.H>
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Multi_Browser.H>
@@ -24,12 +25,17 @@
 #include <FL/Fl_Tabs.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/Fl_Tree.H>
+#include <FL/Fl_Valuator.H>
 #include <FL/names.h>
 
 #include "table.h"
 #include "resizebar.h"
+#include "anchorgroup.h"
+#include "splitter.h"
 
 #include <limits>
+#include <chrono>
+#include <algorithm>
 
 namespace fltklayout {
 
@@ -96,8 +102,10 @@ bool WidgetFactoryBase::set_property(Widgets *widgets,Fl_Widget *o,const std::st
         Fl_Widget *p=widgets->get_widget(val);
         if (!p || !p->as_group() || p==o) 
             return false;
-        Fl_Group *g=p->as_group();
+        Fl_Group *g=p->as_group(),*old=o->parent();
         g->begin(); g->add(o); g->end();
+        if (old!=g) widgets->children_changed(old);
+        widgets->children_changed(g);
         return true;
     }
     if (key=="name")
@@ -182,6 +190,18 @@ bool WidgetFactoryBase::set_property(Widgets *widgets,Fl_Widget *o,const std::st
             o->clear_output();
         return true;
     }
+    if (WidgetInfo::is_anchor_property(key)) {
+        WidgetInfo *info=widgets->get_info(o);
+        if (!info) return false;
+        if (key=="anchor") info->anchor=v&WidgetInfo::ANCHOR_ALL;
+        else if (key=="min_w") info->min_w=v;
+        else if (key=="min_h") info->min_h=v;
+        else if (key=="max_w") info->max_w=v;
+        else info->max_h=v;
+        AnchorGroup *g=dynamic_cast<AnchorGroup*>(o->parent());
+        if (g) g->invalidate(o);
+        return true;
+    }
     if (key=="x") { resize(o,v,o->y(),o->w(),o->h()); return true; }
     if (key=="y") { resize(o,o->x(),v,o->w(),o->h()); return true; }
     if (key=="w") { resize(o,o->x(),o->y(),v,o->h()); return true; }
@@ -208,6 +228,15 @@ std::string WidgetFactoryBase::get_property(Widgets *widgets,Fl_Widget *o,const
     if (key=="labelcolor") return std::to_string((int)o->labelcolor());
     if (key=="selection_color") return std::to_string((int)o->selection_color());
     if (key=="output") return o->output() ? "1" : "0";
+    if (WidgetInfo::is_anchor_property(key)) {
+        WidgetInfo *info=widgets->get_info(o);
+        if (!info) return "0";
+        if (key=="anchor") return std::to_string(info->anchor);
+        if (key=="min_w") return std::to_string(info->min_w);
+        if (key=="min_h") return std::to_string(info->min_h);
+        if (key=="max_w") return std::to_string(info->max_w);
+        return std::to_string(info->max_h);
+    }
     if (key=="x") return std::to_string(o->x());
     if (key=="y") return std::to_string(o->y());
     if (key=="w") return std::to_string(o->w());
@@ -215,6 +244,40 @@ std::string WidgetFactoryBase::get_property(Widgets *widgets,Fl_Widget *o,const
     return "";
 }
 
+Fl_Widget *WidgetFactoryBase::clone(Widgets *widgets,Fl_Widget *o,const std::string &new_name) {
+    Fl_Widget *n=create(widgets,new_name,o->x(),o->y(),o->w(),o->h(),o->label() ? o->label() : "");
+    if (n) copy_properties(o,n);
+    return n;
+}
+void WidgetFactoryBase::copy_properties(Fl_Widget *from,Fl_Widget *to) {
+    if (from->active()) to->activate(); else to->deactivate();
+    if (from->output()) to->set_output(); else to->clear_output();
+    if (from->visible()) to->set_visible(); else to->clear_visible(); // not show(): that would map a window
+    to->copy_label(from->label());
+    to->copy_tooltip(from->tooltip());
+    to->when(from->when());
+    to->box(from->box());
+    to->color(from->color());
+    to->align(from->align());
+    to->labelfont(from->labelfont());
+    to->labelsize(from->labelsize());
+    to->labeltype(from->labeltype());
+    to->labelcolor(from->labelcolor());
+    to->selection_color(from->selection_color());
+
+    // the value of the common value widgets
+    if (Fl_Input_ *f=dynamic_cast<Fl_Input_*>(from)) {
+        Fl_Input_ *t=dynamic_cast<Fl_Input_*>(to);
+        if (t) { t->maximum_size(f->maximum_size()); t->value(f->value()); }
+    } else if (Fl_Button *f=dynamic_cast<Fl_Button*>(from)) {
+        Fl_Button *t=dynamic_cast<Fl_Button*>(to);
+        if (t) t->value(f->value());
+    } else if (Fl_Valuator *f=dynamic_cast<Fl_Valuator*>(from)) {
+        Fl_Valuator *t=dynamic_cast<Fl_Valuator*>(to);
+        if (t) { t->bounds(f->minimum(),f->maximum()); t->step(f->step()); t->value(f->value()); }
+    }
+}
+
 std::vector<std::string> WidgetFactoryBase::get_property_names() {
     std::vector<std::string> property_names;
     auto property_info=get_property_info();
@@ -243,7 +306,12 @@ PropertyMap WidgetFactoryBase::get_property_info() {
             { "x","int" },
             { "y","int" },
             { "w","int" },
-            { "h","int" }
+            { "h","int" },
+            { "anchor","bitmask{LEFT=1,RIGHT=2,TOP=4,BOTTOM=8}" },
+            { "min_w","int" },
+            { "min_h","int" },
+            { "max_w","int" },
+            { "max_h","int" }
     };
     return property_info;
 }
@@ -273,6 +341,10 @@ struct PackFactory : public SimpleWidgetFactory<Fl_Pack,false,true> {
         });
         return pm;
     }
+    virtual void copy_properties(Fl_Widget *from,Fl_Widget *to) {
+        to->type(from->type());
+        BASE::copy_properties(from,to);
+    }
 
     virtual void resize(Fl_Widget *o,int x,int y,int w,int h) { 
         Fl_Group *g=o->as_group();
@@ -287,6 +359,95 @@ struct PackFactory : public SimpleWidgetFactory<Fl_Pack,false,true> {
     }
 };
 
+struct AnchorGroupFactory : public SimpleWidgetFactory<AnchorGroup,false,true> {
+    using BASE=SimpleWidgetFactory<AnchorGroup,false,true>;
+
+    AnchorGroupFactory(Factories *factories,const std::string &factory_name) : BASE(factories,factory_name) { }
+    virtual ~AnchorGroupFactory() { }
+
+    virtual Fl_Widget *create(Widgets *widgets,const std::string &name,int x,int y,int w,int h,const std::string &label) {
+        Fl_Widget *o=BASE::create(widgets,name,x,y,w,h,label);
+        if (o) ((AnchorGroup*)o)->widgets=widgets; // children's anchors live in their WidgetInfo
+        return o;
+    }
+};
+
+struct SplitterFactory : public SimpleWidgetFactory<Splitter,false,true> {
+    using BASE=SimpleWidgetFactory<Splitter,false,true>;
+
+    SplitterFactory(Factories *factories,const std::string &factory_name) : BASE(factories,factory_name) { }
+    virtual ~SplitterFactory() { }
+
+    virtual bool set_property(Widgets *widgets,Fl_Widget *o,const std::string &key,const std::string &val) {
+        Splitter *s=(Splitter*)o;
+        if (key=="type") { s->type(atoi(val.c_str())); s->layout(); s->redraw(); return true; }
+        if (key=="ratios") { s->set_ratios(val); return true; }
+        if (key=="bar_size") { s->bar_size=atoi(val.c_str()); s->layout(); s->redraw(); return true; }
+        if (key=="min_pane") { s->min_pane=atoi(val.c_str()); return true; }
+        return BASE::set_property(widgets,o,key,val);
+    }
+    virtual std::string get_property(Widgets *widgets,Fl_Widget *o,const std::string &key) {
+        Splitter *s=(Splitter*)o;
+        if (key=="type") return std::to_string((int)o->type());
+        if (key=="ratios") return s->get_ratios();
+        if (key=="bar_size") return std::to_string(s->bar_size);
+        if (key=="min_pane") return std::to_string(s->min_pane);
+        return BASE::get_property(widgets,o,key);
+    }
+    virtual PropertyMap get_property_info() {
+        static PropertyMap pm=combine_maps(BASE::get_property_info(),{ 
+            { "type", "enum{Splitter::HORIZONTAL=0,Splitter::VERTICAL=1}" },
+            { "ratios", "string" },
+            { "bar_size", "int" },
+            { "min_pane", "int" }
+        });
+        return pm;
+    }
+    virtual void children_changed(Fl_Widget *o) { ((Splitter*)o)->layout(); }
+    virtual void copy_properties(Fl_Widget *from,Fl_Widget *to) {
+        Splitter *f=(Splitter*)from,*t=(Splitter*)to;
+        t->type(f->type());
+        t->bar_size=f->bar_size;
+        t->min_pane=f->min_pane;
+        t->set_ratios(f->get_ratios());
+        BASE::copy_properties(from,to);
+    }
+};
+
+template<class T>
+struct ResizerBarFactory : public SimpleWidgetFactory<T,false,false> {
+    using BASE=SimpleWidgetFactory<T,false,false>;
+
+    ResizerBarFactory(Factories *factories,const std::string &factory_name) : BASE(factories,factory_name) { }
+    virtual ~ResizerBarFactory() { }
+
+    virtual bool set_property(Widgets *widgets,Fl_Widget *o,const std::string &key,const std::string &val) {
+        T *b=(T*)o;
+        if (key=="ghost") { b->SetGhost(atoi(val.c_str())!=0); return true; }
+        if (key=="live_update_ms") { b->SetLiveUpdateMs(atoi(val.c_str())); return true; }
+        return BASE::set_property(widgets,o,key,val);
+    }
+    virtual std::string get_property(Widgets *widgets,Fl_Widget *o,const std::string &key) {
+        T *b=(T*)o;
+        if (key=="ghost") return b->GetGhost() ? "1" : "0";
+        if (key=="live_update_ms") return std::to_string(b->GetLiveUpdateMs());
+        return BASE::get_property(widgets,o,key);
+    }
+    virtual PropertyMap get_property_info() {
+        static PropertyMap pm=combine_maps(BASE::get_property_info(),{ 
+            { "ghost", "bool" },
+            { "live_update_ms", "int" }
+        });
+        return pm;
+    }
+    virtual void copy_properties(Fl_Widget *from,Fl_Widget *to) {
+        T *f=(T*)from,*t=(T*)to;
+        t->SetGhost(f->GetGhost());
+        t->SetLiveUpdateMs(f->GetLiveUpdateMs());
+        BASE::copy_properties(from,to);
+    }
+};
+
 Factories::Factories() { init(); }
 Factories::~Factories() {
     for (auto &p : factories)
@@ -307,10 +468,12 @@ void Factories::init() {
     add_factory(new SimpleWidgetFactory<Fl_Output,true,false>(this,"Fl_Output"));
     add_factory(new SimpleWidgetFactory<Fl_Multiline_Output,true,false>(this,"Fl_Multiline_Output"));
     add_factory(new PackFactory(this,"Fl_Pack"));
+    add_factory(new AnchorGroupFactory(this,"AnchorGroup"));
+    add_factory(new SplitterFactory(this,"Splitter"));
     add_factory(new SimpleWidgetFactory<Fl_Menu_Bar,true,false>(this,"Fl_MenuBar"));
     add_factory(new SimpleWidgetFactory<StringTable,false,false>(this,"StringTable"));
-    add_factory(new SimpleWidgetFactory<VerticalResizerBar,false,false>(this,"VerticalResizerBar"));
-    add_factory(new SimpleWidgetFactory<HorizontalResizerBar,false,false>(this,"HorizontalResizerBar"));
+    add_factory(new ResizerBarFactory<VerticalResizerBar>(this,"VerticalResizerBar"));
+    add_factory(new ResizerBarFactory<HorizontalResizerBar>(this,"HorizontalResizerBar"));
 }
 
 std::map<std::string,std::vector<PropertyMap> > load_layout_file(const std::string &filename) {
@@ -344,7 +507,8 @@ std::map<std::string,std::vector<PropertyMap> > load_layout_file(const std::stri
                 if (*s==',') s++;
             }
             props["line"]=std::string(line_start,line_end-line_start);
-            layouts[props["layout"]].push_back(props);
+            auto &layout=layouts[props["layout"]];
+            layout.push_back(std::move(props));
         }
 
     } else {
@@ -374,30 +538,45 @@ std::map<std::string,std::vector<PropertyMap> > load_layout_file(const std::stri
                 if (*s==',') s++;
             }
             props["line"]=line;
-            layouts[props["layout"]].push_back(props);
+            auto &layout=layouts[props["layout"]];
+            layout.push_back(std::move(props));
         }
         fclose(fd);
     }
     return layouts;
 }
 
+std::map<std::string,SharedLayout> load_shared_layout_file(const std::string &filename) {
+    std::map<std::string,SharedLayout> shared;
+    for (auto &p : load_layout_file(filename))
+        shared[p.first]=make_shared_layout(std::move(p.second));
+    return shared;
+}
+
 std::string Widgets::load_layout(Factories &factories,Fl_Group *grp,const std::string &filename,const std::string &layout_name,const std::string &prefix,const bool resize_group,const bool zero_xy,const int at_x,const int at_y) {
-    auto layouts=load_layout_file(filename);
+    auto layouts=load_shared_layout_file(filename);
     if (layouts.empty())
         return "could not open file for reading";
 
-    auto layout=layouts[layout_name];
-    if (layout.empty())
+    auto i=layouts.find(layout_name);
+    if (i==layouts.end())
+        return "layout not found in file";
+
+    return load_layout(factories,grp,i->second,prefix,resize_group,zero_xy,at_x,at_y);
+}
+
+std::string Widgets::load_layout(Factories &factories,Fl_Group *grp,const SharedLayout &layout,const std::string &prefix,const bool resize_group,const bool zero_xy,const int at_x,const int at_y) {
+    if (!layout || layout->empty())
         return "layout not found in file";
 
     const int imax=std::numeric_limits<int>::max();
     int minx=zero_xy ? imax:0,miny=zero_xy ? imax:0;
     int maxx=0,maxy=0;
-    for (auto &props : layout) {
-        Fl_Widget *o=get_widget(prefix+props["name"]);
-        if (o) return "Widget with name="+props["name"]+" already exists";
+    for (auto &props : *layout) {
+        Fl_Widget *o=get_widget(prefix+props.get("name"));
+        if (o) return "Widget with name="+props.get("name")+" already exists";
 
-        int x=atoi(props["x"].c_str()),y=atoi(props["y"].c_str()),w=atoi(props["w"].c_str()),h=atoi(props["h"].c_str());
+        int x=atoi(props.get("x").c_str()),y=atoi(props.get("y").c_str()),w=atoi(props.get("w").c_str()),h=atoi(props.get("h").c_str());
         if (x<minx) minx=x;
         if (y<miny) miny=y;
         if (x+w>maxx) maxx=x+w;
@@ -409,22 +588,22 @@ std::string Widgets::load_layout(Factories &factories,Fl_Group *grp,const std::s
         grp->size(rightx-grp->x(),bottomy-grp->y());
     }
 
-    for (auto &props : layout) {
-        auto line=props["line"];
+    for (auto &props : *layout) {
+        auto &line=props.get("line");
 
-        auto factory=props["factory"];
+        auto &factory=props.get("factory");
         if (factory.empty()) return "malformed line (missing factory=): "+line;
-        auto name=props["name"];
+        auto &name=props.get("name");
         FactoryInterface *f=factories.get_factory(factory,name);
         if (!f) return "unknown factory ("+factory+"): "+line;
 
-        int x=atoi(props["x"].c_str()),y=atoi(props["y"].c_str()),w=atoi(props["w"].c_str()),h=atoi(props["h"].c_str());
-        auto label=props["label"];
+        int x=atoi(props.get("x").c_str()),y=atoi(props.get("y").c_str()),w=atoi(props.get("w").c_str()),h=atoi(props.get("h").c_str());
+        auto &label=props.get("label");
 
         Fl_Widget *o=f->create(this,prefix+name,at_x+x-minx,at_y+y-miny,w,h,label);
         if (!o) return "factory failed to create widget (factory="+factory+",name="+name+"): "+line;
 
-        auto parent=props["parent"];
+        auto &parent=props.get("parent");
         Fl_Group *g=grp;
         if (!parent.empty()) {
             Fl_Widget *p=get_widget(prefix+parent);
@@ -433,6 +612,7 @@ std::string Widgets::load_layout(Factories &factories,Fl_Group *grp,const std::s
             g=p->as_group();
         }
         g->begin(); g->add(o); g->end();
+        children_changed(g);
 
         const static std::set<std::string> ignore{ "line","layout","factory","name","x","y","w","h","label","parent" };
         for (auto &nv : props) {
@@ -448,7 +628,7 @@ std::string Widgets::load_layout(Factories &factories,Fl_Group *grp,const std::s
 
 Fl_Widget *LayoutWidgetFactory::create(Widgets *widgets,const std::string &widget_name,int cx,int cy,int cw,int ch,const std::string &clabel) {
     auto layout_widget=new LayoutWidget(0,0,1,1,"");
-    layout_widget->update_layout(*this,layout);
+    layout_widget->update_layout(*this);
 
     ((Fl_Widget*)layout_widget)->resize(cx,cy,cw,ch);
     layout_widget->copy_label(clabel.c_str());
@@ -461,10 +641,42 @@ Fl_Widget *LayoutWidgetFactory::create(Widgets *widgets,const std::string &widge
     return layout_widget;
 }
 
-void LayoutWidget::update_layout(LayoutWidgetFactory &factory,std::vector<PropertyMap> &layout) {
+Fl_Widget *LayoutWidgetFactory::clone(Widgets *widgets,Fl_Widget *o,const std::string &new_name) {
+    LayoutWidget *from=(LayoutWidget*)o;
+    auto layout_widget=new LayoutWidget(o->x(),o->y(),o->w(),o->h(),"");
+
+    // sub widgets are already built => copy them instead of re-running update_layout()
+    for (int i=0;i<from->children();i++) {
+        Fl_Widget *c=from->child(i);
+        auto name=from->widgets.get_name(c);
+        if (name.empty()) continue; // not managed
+
+        Fl_Widget *n=layout_widget->widgets.clone_from(from->widgets,c,name);
+        if (!n) continue; // clone failed
+        layout_widget->add(n);
+        if (from->resizable()==c) layout_widget->resizable(n);
+    }
+    layout_widget->end();
+    layout_widget->init_sizes();
+    layout_widget->layout=from->layout;
+    layout_widget->copy_label(o->label());
+    copy_properties(o,layout_widget);
+
+    WidgetInfo *info=new WidgetInfo();
+    info->init(widgets,new_name,this,layout_widget);
+    widgets->add_widget(info);
+
+    layout_widget->callback(callback_helper,widgets);
+    return layout_widget;
+}
+
+void LayoutWidget::update_layout(LayoutWidgetFactory &factory,const SharedLayout &new_layout) {
+    layout=new_layout;
 
     // destroy any previous widgets
     clear();
+    mark_clean(); // no children => nothing pending
+    if (!layout) return;
 
     // work out layout dimensions
     int minx,miny;
@@ -473,36 +685,36 @@ void LayoutWidget::update_layout(LayoutWidgetFactory &factory,std::vector<Proper
     minx=imax,miny=imax;
     num_top_level=0;
     int maxx=0,maxy=0;
-    for (auto &props : layout) {
-        int x=atoi(props["x"].c_str()),y=atoi(props["y"].c_str()),w=atoi(props["w"].c_str()),h=atoi(props["h"].c_str());
+    for (auto &props : *layout) {
+        int x=atoi(props.get("x").c_str()),y=atoi(props.get("y").c_str()),w=atoi(props.get("w").c_str()),h=atoi(props.get("h").c_str());
         if (x<minx) minx=x;
         if (x+w>maxx) maxx=x+w;
         if (y<miny) miny=y;
         if (y+h>maxy) maxy=y+h;
 
-        if (props["parent"].empty())
+        if (props.get("parent").empty())
             num_top_level++;
     }
     int lw=maxx>minx ? maxx-minx : 0;
     int lh=maxy>miny ? maxy-miny : 0;
 
     int cw=w(),ch=h();
-    size(lw,lh);
+    Fl_Group::resize(x(),y(),lw,lh); // never deferred, children below are created for this size
 
     begin();
-    for (auto &props : layout) {
-        auto factory_name=props["factory"];
-        auto name=props["name"];
+    for (auto &props : *layout) {
+        auto &factory_name=props.get("factory");
+        auto &name=props.get("name");
         FactoryInterface *f=factory.factories->get_factory(factory_name,name);
         if (!f) continue; // unknown factory
 
-        int ox=atoi(props["x"].c_str()),oy=atoi(props["y"].c_str()),ow=atoi(props["w"].c_str()),oh=atoi(props["h"].c_str());
-        auto label=props["label"];
+        int ox=atoi(props.get("x").c_str()),oy=atoi(props.get("y").c_str()),ow=atoi(props.get("w").c_str()),oh=atoi(props.get("h").c_str());
+        auto &label=props.get("label");
 
         Fl_Widget *o=f->create(&widgets,name,x()+ox-minx,y()+oy-miny,ow,oh,label);
         if (!o) continue; // create failed
 
-        auto parent=props["parent"];
+        auto &parent=props.get("parent");
         Fl_Group *g=as_group();
         if (!parent.empty()) {
             Fl_Widget *p=widgets.get_widget(parent);
@@ -510,6 +722,7 @@ void LayoutWidget::update_layout(LayoutWidgetFactory &factory,std::vector<Proper
             g=p->as_group();
         }
         g->begin(); g->add(o); g->end();
+        widgets.children_changed(g);
 
         const static std::set<std::string> ignore{ "line","layout","factory","name","x","y","w","h","label","parent" };
         for (auto &nv : props) {
@@ -519,11 +732,142 @@ void LayoutWidget::update_layout(LayoutWidgetFactory &factory,std::vector<Proper
     }
 
     end();
-    size(cw,ch);
+    Fl_Group::resize(x(),y(),cw,ch);
+}
+
+LayoutWidget::PassStats LayoutWidget::pass_stats;
+bool LayoutWidget::defer_resize=false;
+std::vector<LayoutWidget*> LayoutWidget::dirty;
+size_t LayoutWidget::dirty_count=0;
+bool LayoutWidget::in_pass=false;
+
+void LayoutWidget::resize(int X,int Y,int W,int H) {
+    if (defer_resize && !in_pass) {
+        if (!layout_dirty) {
+            laid_x=x(); laid_y=y(); laid_w=w(); laid_h=h();
+            layout_dirty=true;
+            if (!dirty_count++) Fl::add_check(layout_pass_cb);
+            dirty_slot=dirty.size();
+            dirty.push_back(this);
+        }
+        pass_stats.resizes++;
+        Fl_Widget::resize(X,Y,W,H); // new bounds visible now, children follow in layout_pass()
+        return;
+    }
+    layout_children(X,Y,W,H);
+}
+
+void LayoutWidget::mark_clean() {
+    if (!layout_dirty) return;
+    layout_dirty=false;
+    dirty[dirty_slot]=NULL; // O(1), the slot is dropped by the next pass
+    dirty_slot=-1;
+    if (!--dirty_count) {
+        Fl::remove_check(layout_pass_cb);
+        if (!in_pass) dirty.clear();
+    }
+}
+
+void LayoutWidget::layout_children(int X,int Y,int W,int H) {
+    if (layout_dirty) {
+        // children are still laid out for the old bounds => let Fl_Group::resize() work from those
+        Fl_Widget::resize(laid_x,laid_y,laid_w,laid_h);
+        mark_clean();
+    }
+    if (X==x() && Y==y() && W==w() && H==h()) { // nothing to do for this subtree
+        pass_stats.skipped++;
+        return;
+    }
+    pass_stats.widgets_visited+=1+children();
+    Fl_Group::resize(X,Y,W,H);
+}
+
+void LayoutWidget::layout_pass() {
+    if (!dirty_count || in_pass) return;
+    const auto start=std::chrono::steady_clock::now();
+    in_pass=true;
+
+    // top-down, so nested LayoutWidgets are laid out once by their parent's pass.
+    // by slot => a widget laid out (or deleted) meanwhile has a NULL slot
+    std::vector<std::pair<int,size_t> > order;
+    for (size_t i=0;i<dirty.size();i++) {
+        if (!dirty[i]) continue;
+        int depth=0;
+        for (Fl_Widget *p=dirty[i]->parent();p;p=p->parent()) depth++;
+        order.push_back(std::make_pair(depth,i));
+    }
+    std::stable_sort(order.begin(),order.end(),[](const std::pair<int,size_t> &a,const std::pair<int,size_t> &b) {
+        return a.first<b.first;
+    });
+    for (auto &p : order) {
+        LayoutWidget *w=dirty[p.second];
+        if (!w) continue; // done by an ancestor
+        w->layout_children(w->x(),w->y(),w->w(),w->h());
+        w->redraw();
+    }
+
+    size_t n=0; // compact once (every entry is normally laid out by now)
+    for (auto w : dirty) 
+        if (w) { w->dirty_slot=n; dirty[n++]=w; }
+    dirty.resize(n);
+    in_pass=false;
+    pass_stats.passes++;
+    pass_stats.seconds+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+Fl_Widget *Widgets::clone(Fl_Widget *o,const std::string &new_name,const bool deep) {
+    Fl_Group *parent=o ? o->parent() : NULL;
+    Fl_Widget *n=clone_from(*this,o,new_name,deep);
+    if (n && parent) {
+        parent->insert(*n,parent->find(o)+1);
+        children_changed(parent);
+    }
+    return n;
+}
+
+Fl_Widget *Widgets::clone_from(Widgets &src,Fl_Widget *o,const std::string &new_name,const bool deep) {
+    WidgetInfo *winfo=src.get_info(o);
+    if (!winfo) return NULL; // not managed
+    if (new_name.empty() || get_widget(new_name)) return NULL; // invalid or existing name
+
+    Fl_Group *current=Fl_Group::current(); // new widgets must not be auto-added to o, and factories may leave groups open
+    Fl_Group::current(NULL);
+    Fl_Widget *n=winfo->factory->clone(this,o,new_name);
+    WidgetInfo *ninfo=n ? get_info(n) : NULL;
+    if (ninfo) {
+        ninfo->anchor=winfo->anchor;
+        ninfo->min_w=winfo->min_w; ninfo->min_h=winfo->min_h;
+        ninfo->max_w=winfo->max_w; ninfo->max_h=winfo->max_h;
+    }
+    if (n && deep && winfo->factory->is_group()) {
+        Fl_Group *g=o->as_group(),*ng=n->as_group();
+        for (int i=0;i<g->children();i++) {
+            Fl_Widget *c=g->child(i);
+            WidgetInfo *cinfo=src.get_info(c);
+            if (!cinfo) continue; // not managed
+
+            std::string child_name=cinfo->name;
+            if (&src==this) {
+                // remap tile1.x => tile2.x, x => tile2.x
+                if (child_name.compare(0,winfo->name.size()+1,winfo->name+".")==0)
+                    child_name=new_name+child_name.substr(winfo->name.size());
+                else
+                    child_name=new_name+"."+child_name;
+            }
+            Fl_Widget *nc=clone_from(src,c,child_name,deep);
+            if (!nc) continue; // name clash
+            ng->add(nc);
+            if (g->resizable()==c) ng->resizable(nc);
+        }
+        ng->init_sizes();
+        children_changed(ng);
+    }
+    Fl_Group::current(current);
+    return n;
 }
 
 std::string Factories::load_layouts_as_widgets(const std::string &filename) {
-    auto layouts=load_layout_file(filename);
+    auto layouts=load_shared_layout_file(filename);
     if (layouts.empty())
         return "could not open file "+filename;
 
@@ -531,13 +875,16 @@ std::string Factories::load_layouts_as_widgets(const std::string &filename) {
         auto &layout_name=p.first;
         auto &layout=p.second;
 
-        if (!layout.empty())
+        if (!layout->empty())
             add_factory(new LayoutWidgetFactory(this,layout_name,layout));
     }
     return ""; // success
 }
 
 std::string Factories::add_layout_widget_factory(const std::string &factory_name,const std::vector<PropertyMap> &layout) {
+    return add_layout_widget_factory(factory_name,make_shared_layout(layout));
+}
+std::string Factories::add_layout_widget_factory(const std::string &factory_name,const SharedLayout &layout) {
     add_factory(new LayoutWidgetFactory(this,factory_name,layout));
     return ""; // success
 }
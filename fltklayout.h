@@ -9,6 +9,7 @@
 #include <map>
 #include <set>
 #include <vector>
+#include <memory>
 #include <functional>
 
 namespace fltklayout {
@@ -21,8 +22,21 @@ struct PropertyMap : public std::map<std::string,std::string> {
     PropertyMap(std::initializer_list<value_type> init) : std::map<std::string,std::string>(init) { }
     void deserialize(const std::string &props);
     std::string serialize();
+
+    const std::string &get(const std::string &key) const { // like operator[] but usable on shared (const) layouts
+        static const std::string empty;
+        auto i=find(key);
+        return i!=end() ? i->second : empty;
+    }
 };
 
+// an immutable parsed layout, shared by factories, layout widget instances and the designer.
+// to edit, build a new vector and make a new snapshot (copy-on-write)
+typedef std::shared_ptr<const std::vector<PropertyMap> > SharedLayout;
+inline SharedLayout make_shared_layout(std::vector<PropertyMap> layout) {
+    return std::make_shared<const std::vector<PropertyMap> >(std::move(layout));
+}
+
 template <typename T>
 inline T combine_maps(const T &m1,const T &m2) {
     T m(m1);
@@ -63,6 +77,13 @@ struct WidgetInfo { // extra info stored for each named widget
     Fl_Widget *o=nullptr;                  // the actual widget itself
     std::function<void(Fl_Widget*,WidgetInfo*)> callback; // callback
 
+    static const int ANCHOR_LEFT=1,ANCHOR_RIGHT=2,ANCHOR_TOP=4,ANCHOR_BOTTOM=8,ANCHOR_ALL=15;
+    int anchor=0;                          // ANCHOR_* edges kept at a fixed distance when parent is an AnchorGroup (0=default)
+    int min_w=0,min_h=0,max_w=0,max_h=0;   // size limits used by AnchorGroup (0=no limit)
+    static bool is_anchor_property(const std::string &key) { // only saved when not 0, most widgets are not in an AnchorGroup
+        return key=="anchor" || key=="min_w" || key=="min_h" || key=="max_w" || key=="max_h";
+    }
+
     WidgetInfo() = default;
     virtual ~WidgetInfo() { delete tracker; }
 
@@ -101,10 +122,14 @@ struct FactoryInterface { // a factory that can manufacture widgets, and also ge
     virtual std::vector<std::string> get_property_names()=0;
     virtual PropertyMap get_property_info()=0;
     virtual void resize(Fl_Widget *o,int x,int y,int w,int h)=0;
+    virtual Fl_Widget *clone(Widgets *widgets,Fl_Widget *o,const std::string &new_name)=0; // copy typed state directly (no property strings)
+    virtual void children_changed(Fl_Widget *o) { } // group o gained or lost children (Fl_Group::add()/remove() are not virtual)
 };
 
 // load file from disk into STL data structure
 std::map<std::string,std::vector<PropertyMap> > load_layout_file(const std::string &filename);
+// same, but as shared snapshots
+std::map<std::string,SharedLayout> load_shared_layout_file(const std::string &filename);
 
 class Factories { // a collection of widget factories
     typedef std::map<std::string,FactoryInterface*> FactoryMap;
@@ -159,6 +184,7 @@ public:
 
     std::string load_layouts_as_widgets(const std::string &filename);
     std::string add_layout_widget_factory(const std::string &factory_name,const std::vector<PropertyMap> &layout);
+    std::string add_layout_widget_factory(const std::string &factory_name,const SharedLayout &layout);
 };
 
 class Widgets { // a collection of named widgets
@@ -196,6 +222,14 @@ public:
                             const bool zero_xy=false,
                             const int at_x=0,
                             const int at_y=0); 
+    std::string load_layout(Factories &factories,
+                            Fl_Group *grp,
+                            const SharedLayout &layout,
+                            const std::string &prefix="",
+                            const bool resize_group=false,
+                            const bool zero_xy=false,
+                            const int at_x=0,
+                            const int at_y=0); 
 
     bool is_managed(Fl_Widget *o) { return get_info(o); }
 
@@ -211,6 +245,10 @@ public:
         WidgetInfo *winfo=get_info(o);
         return winfo ? winfo->factory : NULL;
     }
+    void children_changed(Fl_Widget *g) { // call after adding/removing children of a managed group
+        FactoryInterface *f=g ? get_factory(g) : NULL;
+        if (f) f->children_changed(g);
+    }
     std::string get_factory_name(Fl_Widget *o) {
         WidgetInfo *winfo=get_info(o);
         return winfo ? winfo->factory->name() : "";
@@ -323,11 +361,19 @@ public:
         PropertyMap props;
         FactoryInterface *f=get_factory(o);
         if (f) {
-            for (auto &name : f->get_property_names())
-                props[name]=f->get_property(this,o,name);
+            for (auto &name : f->get_property_names()) {
+                std::string val=f->get_property(this,o,name);
+                if (val=="0" && WidgetInfo::is_anchor_property(name)) continue;
+                props[name]=val;
+            }
         }
         return props;
     }
+
+    // duplicate a managed widget next to the original, if deep then managed children are cloned too (renamed new_name.child)
+    Fl_Widget *clone(Fl_Widget *o,const std::string &new_name,const bool deep=true);
+    // clone widget o managed by src into this collection (children keep their names if src is a different collection)
+    Fl_Widget *clone_from(Widgets &src,Fl_Widget *o,const std::string &new_name,const bool deep=true);
 };
 
 struct WidgetFactoryBase : public FactoryInterface {
@@ -346,11 +392,16 @@ struct WidgetFactoryBase : public FactoryInterface {
     virtual std::vector<std::string> get_property_names();
     virtual PropertyMap get_property_info();
     virtual void resize(Fl_Widget *o,int x,int y,int w,int h) { o->resize(x,y,w,h); }
+    virtual Fl_Widget *clone(Widgets *widgets,Fl_Widget *o,const std::string &new_name);
+    virtual void copy_properties(Fl_Widget *from,Fl_Widget *to); // used by clone(): label, tooltip, when(), visibility, looks and input/button/valuator values, not name/parent/geometry/callback/images
 
     PropertyMap get_widget_properties(Widgets *widgets,Fl_Widget *o) {
         PropertyMap props;
-        for (auto &name : get_property_names())
-            props[name]=get_property(widgets,o,name);
+        for (auto &name : get_property_names()) {
+            std::string val=get_property(widgets,o,name);
+            if (val=="0" && WidgetInfo::is_anchor_property(name)) continue;
+            props[name]=val;
+        }
         return props;
     }
 };
@@ -384,31 +435,67 @@ struct SimpleWidgetFactory : public WidgetFactoryBase {
 };
 
 struct LayoutWidgetFactory : public WidgetFactoryBase {
-    std::vector<PropertyMap> layout;
+    SharedLayout layout; // shared with every LayoutWidget created from this factory
 
     virtual bool border_visible() { return false; }
     virtual bool is_group() { return false; }
 
-    LayoutWidgetFactory(Factories *factories,const std::string &factory_name,const std::vector<PropertyMap> &sub_widget_props)
+    LayoutWidgetFactory(Factories *factories,const std::string &factory_name,const SharedLayout &sub_widget_props)
     : WidgetFactoryBase(factories,factory_name),layout(sub_widget_props)
     {
         factory_type=FACTORY_TYPE_LAYOUT_WIDGETS;
     }
+    LayoutWidgetFactory(Factories *factories,const std::string &factory_name,const std::vector<PropertyMap> &sub_widget_props)
+    : LayoutWidgetFactory(factories,factory_name,make_shared_layout(sub_widget_props))
+    { }
 
     virtual ~LayoutWidgetFactory() { }
 
     virtual Fl_Widget *create(Widgets *widgets,const std::string &widget_name,int cx,int cy,int cw,int ch,const std::string &clabel);
+    virtual Fl_Widget *clone(Widgets *widgets,Fl_Widget *o,const std::string &new_name); // copies already built sub widgets
 
-    void update_layout(const std::vector<PropertyMap> &new_layout) { layout=new_layout; }
+    void update_layout(const SharedLayout &new_layout) { // keeps the current snapshot if nothing changed
+        if (!layout || !new_layout || *layout!=*new_layout) layout=new_layout;
+    }
+    void update_layout(const std::vector<PropertyMap> &new_layout) { layout=make_shared_layout(new_layout); }
 };
 
 struct LayoutWidget : public Fl_Group {
     Widgets widgets;
+    SharedLayout layout; // snapshot the sub widgets were built from
 
     LayoutWidget(int x,int y,int w,int h,const char *label) : Fl_Group(x,y,w,h,label) { }
-    virtual ~LayoutWidget() { }
+    virtual ~LayoutWidget() { mark_clean(); }
+
+    void update_layout(LayoutWidgetFactory &factory,const SharedLayout &layout);
+    void update_layout(LayoutWidgetFactory &factory) { update_layout(factory,factory.layout); }
+
+    // deferred resizing: when enabled resize() only records the new bounds, and children of all
+    // resized LayoutWidgets are laid out in one top-down pass per event loop iteration (Fl::add_check)
+    struct PassStats {
+        unsigned long passes=0;          // layout passes run
+        unsigned long resizes=0;         // resize() calls deferred into a pass
+        unsigned long widgets_visited=0; // LayoutWidgets laid out + their direct children
+        unsigned long skipped=0;         // LayoutWidgets whose bounds ended up unchanged
+        double seconds=0;                // time spent in passes
+    };
+    static PassStats pass_stats;
+    static bool defer_resize;            // off by default => resize() behaves like Fl_Group::resize()
+
+    virtual void resize(int X,int Y,int W,int H);
+    static void layout_pass(); // run any pending layout now
 
-    void update_layout(LayoutWidgetFactory &factory,std::vector<PropertyMap> &layout);
+private:
+    bool layout_dirty=false;
+    int dirty_slot=-1;                       // index in dirty while layout_dirty
+    int laid_x=0,laid_y=0,laid_w=0,laid_h=0; // bounds the children were last laid out for (valid when dirty)
+    static std::vector<LayoutWidget*> dirty; // NULL => cleaned since it was added, compacted by layout_pass()
+    static size_t dirty_count;               // non NULL entries in dirty
+    static bool in_pass;
+
+    void mark_clean();
+    void layout_children(int X,int Y,int W,int H);
+    static void layout_pass_cb(void*) { layout_pass(); }
 };
 
 inline Fl_Widget *create_widget(Widgets &widgets,Factories &factories,const std::string &factory,const std::string &name,int x,int y,int w,int h,const std::string &label="") {
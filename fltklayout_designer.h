@@ -991,7 +991,7 @@ public:
     }
 
     std::string load(const std::string &filename) {
-        auto layouts=load_layout_file(filename);
+        auto layouts=load_shared_layout_file(filename);
         if (layouts.empty()) 
             return "Could not read file "+filename;
 
@@ -1007,7 +1007,7 @@ public:
             auto layout=i.first;
             tabs_remove(layout);
             Tab *t=tabs_add(layout);
-            err=widgets.load_layout(factories,t->as_group(),filename,layout);
+            err=widgets.load_layout(factories,t->as_group(),i.second);
             if (!err.empty()) break;
         }
 
@@ -1130,8 +1130,17 @@ public:
         }
     }
 
+    SharedLayout get_tab_layout(Tab *tab) { // snapshot of the widgets in a tab
+        std::vector<PropertyMap> layout;
+        auto tab_widgets=tab->get_child_widgets();
+        for (auto &o : tab_widgets)
+            layout.push_back(widgets.get_properties(o));
+        return make_shared_layout(std::move(layout));
+    }
+
     void update_layout_widgets(Tab *changed_tab) {
 
+        std::map<std::string,SharedLayout> tab_layouts; // one snapshot per tab, shared by its factory and all instances
         auto factory_names=factories.get_factory_names(); // all factories
         if (!changed_tab) {
             // make LayoutWidgetFactorys factories match tabs
@@ -1139,10 +1148,8 @@ public:
                 Tab *tab=(Tab*)tabs->child(i);
                 FactoryInterface *f=factories.get_factory(tab->label());
 
-                std::vector<PropertyMap> layout;
-                auto tab_widgets=tab->get_child_widgets();
-                for (auto &o : tab_widgets)
-                    layout.push_back(widgets.get_properties(o));
+                SharedLayout layout=get_tab_layout(tab);
+                tab_layouts[tab->label()]=layout;
 
                 if (!f) {
                     // New Layout added => add new LayoutWidgetFactory
@@ -1186,20 +1193,18 @@ public:
             return !has_dependency(a->factory_name,b->factory_name);
         });
         for (auto f : lwf) {
-            Tab *tab=tabs_get(f->factory_name);
-            std::vector<PropertyMap> layout;
-            auto tab_widgets=tab->get_child_widgets();
-            for (auto &o : tab_widgets)
-                layout.push_back(widgets.get_properties(o));
-
             LayoutWidgetFactory &layout_factory=*(LayoutWidgetFactory*)f;
-            layout_factory.update_layout(layout);
+            auto i=tab_layouts.find(f->factory_name);
+            if (i!=tab_layouts.end())
+                layout_factory.update_layout(i->second);
+            else
+                layout_factory.update_layout(get_tab_layout(tabs_get(f->factory_name)));
 
             auto name2infos=widgets.get_name2infos();
             for (auto &p : name2infos) {
                 WidgetInfo *info=p.second;
                 if (info->factory==f) 
-                    ((LayoutWidget*)info->o)->update_layout(layout_factory,layout);
+                    ((LayoutWidget*)info->o)->update_layout(layout_factory);
             }
         }
     }
@@ -1211,8 +1216,8 @@ public:
             if (factory_name1==factory_name2)
                 return true;
             LayoutWidgetFactory &layout_factory=*(LayoutWidgetFactory*)f;
-            for (auto &pm : layout_factory.layout) {
-                const std::string &factory_name=pm["factory"];
+            for (auto &pm : *layout_factory.layout) {
+                const std::string &factory_name=pm.get("factory");
                 if (factory_name==factory_name2 || has_dependency(factory_name,factory_name2)) 
                     return true;
             }
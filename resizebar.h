@@ -6,14 +6,46 @@
 #include <FL/Fl_Box.H>
 #include <FL/fl_draw.H>
 
+#include <chrono>
+
 namespace fltklayout {
 
+// ghost mode shared by both resizer bars: while dragging only an overlay guide is drawn and the
+// neighbours are resized once on FL_RELEASE (or at most every live_update_ms while dragging)
+struct ResizerBarGhost {
+    bool ghost=false;
+    int live_update_ms=0;   // 0 => only resize on release
+    int pending=0;          // drag distance not yet applied to the neighbours
+    std::chrono::steady_clock::time_point last_update;
+
+    bool update_due() {
+        if (live_update_ms<=0) return false;
+        auto now=std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(now-last_update).count()<live_update_ms) return false;
+        last_update=now;
+        return true;
+    }
+    void draw(Fl_Widget *bar,int dx,int dy) { // XOR guide where the bar would go
+        Fl_Window *win=bar->window();
+        if (!win) return;
+        win->make_current();
+        fl_overlay_rect(bar->x()+dx,bar->y()+dy,bar->w(),bar->h());
+    }
+    void clear(Fl_Widget *bar) {
+        Fl_Window *win=bar->window();
+        if (!win) return;
+        win->make_current();
+        fl_overlay_clear();
+    }
+};
+
 // based on erco horizontal resizer bar widget
 // http://seriss.com/people/erco/fltk/#ResizerBar
 class VerticalResizerBar : public Fl_Box {
     int last_y;
     int min_h;                                                        // min height for widget above us
-    void HandleDrag(int diff) {
+    ResizerBarGhost ghost;
+    int ClampDrag(int diff) {
         Fl_Scroll *grp=(Fl_Scroll*)parent();
         int top=y();
         int bot=y()+h();
@@ -23,13 +55,20 @@ class VerticalResizerBar : public Fl_Box {
         for (int t=0; t<grp->children(); t++) {
             Fl_Widget *w=grp->child(t);
             if (diff<0 && w->y()+w->h() == top) {                           // found widget directly above?
-                if (w->h()+diff < min_h) diff=w->h()-min_h;   // clamp
+                if (w->h()+diff < min_h) diff= w->h()>min_h ? min_h-w->h() : 0;   // clamp
                 break;                                                // done with first pass
             } else if (diff>0 && w->y() == bot) {                           // found widget directly below?
-                if (w->h()-diff < min_h) diff=w->h()-min_h;   // clamp
+                if (w->h()-diff < min_h) diff= w->h()>min_h ? w->h()-min_h : 0;   // clamp
                 break;                                                // done with first pass
             }
         }
+        return diff;
+    }
+    void HandleDrag(int diff) {
+        Fl_Scroll *grp=(Fl_Scroll*)parent();
+        int top=y();
+        int bot=y()+h();
+        diff=ClampDrag(diff);
         // Second pass: find widgets below us, move based on clamped diff
         for (int t=0; t<grp->children(); t++) {
             Fl_Widget *w=grp->child(t);
@@ -55,6 +94,10 @@ public:
     }
     void SetMinHeight(int val) { min_h=val; }
     int  GetMinHeight() const { return min_h; }
+    void SetGhost(bool val) { ghost.ghost=val; }
+    bool GetGhost() const { return ghost.ghost; }
+    void SetLiveUpdateMs(int val) { ghost.live_update_ms=val; }
+    int  GetLiveUpdateMs() const { return ghost.live_update_ms; }
     int handle(int e) {
         int ret=0;
         int this_y=Fl::event_y_root();
@@ -62,12 +105,34 @@ public:
             case FL_FOCUS: ret=1; break;
             case FL_ENTER: ret=1; fl_cursor(FL_CURSOR_NS);      break;
             case FL_LEAVE: ret=1; fl_cursor(FL_CURSOR_DEFAULT); break;
-            case FL_PUSH:  ret=1; last_y=this_y;              break;
+            case FL_PUSH:  
+                ret=1; 
+                last_y=this_y;
+                ghost.pending=0;
+                ghost.last_update=std::chrono::steady_clock::now();
+                break;
             case FL_DRAG:
-                HandleDrag(this_y-last_y);
+                if (ghost.ghost) {
+                    ghost.pending=ClampDrag(ghost.pending+this_y-last_y); // the guide stops where HandleDrag() would
+                    if (ghost.update_due()) {
+                        ghost.clear(this);
+                        HandleDrag(ghost.pending);
+                        ghost.pending=0;
+                    } else
+                        ghost.draw(this,0,ghost.pending);
+                } else
+                    HandleDrag(this_y-last_y);
                 last_y=this_y;
                 ret=1;
                 break;
+            case FL_RELEASE:
+                if (ghost.ghost) {
+                    ghost.clear(this);
+                    if (ghost.pending) HandleDrag(ghost.pending);
+                    ghost.pending=0;
+                }
+                ret=1;
+                break;
             default: break;
         }
         return(Fl_Box::handle(e) | ret);
@@ -78,7 +143,8 @@ class HorizontalResizerBar : public Fl_Box {
     int orig_w;
     int last_x;
     int min_w;                                                        // min height for widget above us
-    void HandleDrag(int diff) {
+    ResizerBarGhost ghost;
+    int ClampDrag(int diff) {
         Fl_Scroll *grp=(Fl_Scroll*)parent();
         int left=x();
         int right=x()+w();
@@ -88,13 +154,20 @@ class HorizontalResizerBar : public Fl_Box {
         for (int t=0; t<grp->children(); t++) {
             Fl_Widget *w=grp->child(t);
             if (diff<0 && w->x()+w->w()==left) {                          // found widget directly to left?
-                if (w->w()+diff<min_w) diff=w->w()-min_w;   // clamp
+                if (w->w()+diff<min_w) diff= w->w()>min_w ? min_w-w->w() : 0;   // clamp
                 break;                                                // done with first pass
             } else if (diff>0 && w->x()==right) {                          // found widget directly to right?
-                if (w->w()-diff<min_w) diff=w->w()-min_w;   // clamp
+                if (w->w()-diff<min_w) diff= w->w()>min_w ? w->w()-min_w : 0;   // clamp
                 break;                                                // done with first pass
             }
         }
+        return diff;
+    }
+    void HandleDrag(int diff) {
+        Fl_Scroll *grp=(Fl_Scroll*)parent();
+        int left=x();
+        int right=x()+w();
+        diff=ClampDrag(diff);
         // Second pass: find widgets to right of us, move based on clamped diff
         for (int t=0; t<grp->children(); t++) {
             Fl_Widget *w=grp->child(t);
@@ -120,6 +193,10 @@ public:
     }
     void SetMinWidth(int val) { min_w=val; }
     int  GetMinWidth() const { return min_w; }
+    void SetGhost(bool val) { ghost.ghost=val; }
+    bool GetGhost() const { return ghost.ghost; }
+    void SetLiveUpdateMs(int val) { ghost.live_update_ms=val; }
+    int  GetLiveUpdateMs() const { return ghost.live_update_ms; }
     int handle(int e) {
         int ret=0;
         int this_x=Fl::event_x_root();
@@ -127,12 +204,34 @@ public:
             case FL_FOCUS: ret=1; break;
             case FL_ENTER: ret=1; fl_cursor(FL_CURSOR_WE);      break;
             case FL_LEAVE: ret=1; fl_cursor(FL_CURSOR_DEFAULT); break;
-            case FL_PUSH:  ret=1; last_x=this_x;              break;
+            case FL_PUSH:  
+                ret=1; 
+                last_x=this_x;
+                ghost.pending=0;
+                ghost.last_update=std::chrono::steady_clock::now();
+                break;
             case FL_DRAG:
-                HandleDrag(this_x-last_x);
+                if (ghost.ghost) {
+                    ghost.pending=ClampDrag(ghost.pending+this_x-last_x); // the guide stops where HandleDrag() would
+                    if (ghost.update_due()) {
+                        ghost.clear(this);
+                        HandleDrag(ghost.pending);
+                        ghost.pending=0;
+                    } else
+                        ghost.draw(this,ghost.pending,0);
+                } else
+                    HandleDrag(this_x-last_x);
                 last_x=this_x;
                 ret=1;
                 break;
+            case FL_RELEASE:
+                if (ghost.ghost) {
+                    ghost.clear(this);
+                    if (ghost.pending) HandleDrag(ghost.pending);
+                    ghost.pending=0;
+                }
+                ret=1;
+                break;
             default: break;
         }
         return(Fl_Box::handle(e) | ret);
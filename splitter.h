@@ -0,0 +1,253 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+#include <FL/fl_draw.H>
+
+#include "fltklayout.h"
+
+namespace fltklayout {
+
+// container that lays out its children as panes side by side (HORIZONTAL) or stacked (VERTICAL)
+// with a draggable bar between each pair. pane sizes are kept as ratios of the space left after the bars,
+// so they survive resizing and can be stored as a layout property
+class Splitter : public Fl_Group {
+    std::vector<double> ratios; // one per pane, sums to 1
+    bool ratios_pending=false;  // set_ratios() for panes not added yet
+
+    int drag_bar=-1;            // bar being dragged (between pane drag_bar and drag_bar+1), -1 if none
+    int drag_start=0;           // mouse position at FL_PUSH
+    int drag_size1=0,drag_size2=0; // sizes of the two adjacent panes at FL_PUSH
+
+    bool horizontal() const { return type()==HORIZONTAL; }
+    int pane_pos(Fl_Widget *o) const { return horizontal() ? o->x() : o->y(); }
+    int pane_size(Fl_Widget *o) const { return horizontal() ? o->w() : o->h(); }
+    int avail() const { // space for panes
+        const int n=children();
+        const int total=horizontal() ? w() : h();
+        return n>1 ? total-(n-1)*bar_size : total;
+    }
+    void set_pane(Fl_Widget *o,int p,int s) {
+        if (horizontal())
+            o->resize(p,y(),s,h());
+        else
+            o->resize(x(),p,w(),s);
+    }
+
+    void normalize() {
+        double sum=0;
+        for (auto r : ratios) sum+=r;
+        if (sum>0)
+            for (auto &r : ratios) r/=sum;
+    }
+    void pane_added(const int index) { // share of the new pane: its own size next to the others
+        if (ratios_pending || (int)ratios.size()!=children()-1) return; // layout() sorts it out
+        const int total=avail();
+        double r=total>0 ? (double)std::min(pane_size(child(index)),total)/total : 1.0/children();
+        if (children()==1) r=1;
+        for (auto &x : ratios) x*=1-r;
+        ratios.insert(ratios.begin()+index,r);
+        normalize();
+    }
+    void ratios_from_panes() {
+        const int n=children();
+        ratios.assign(n,n ? 1.0/n : 0);
+        int sum=0;
+        for (int i=0;i<n;i++) sum+=pane_size(child(i));
+        if (sum<=0) return;
+        for (int i=0;i<n;i++) ratios[i]=(double)pane_size(child(i))/sum;
+    }
+
+    int bar_at(int mx,int my) const { // bar under the mouse, or -1
+        const int m=horizontal() ? mx : my;
+        for (int i=0;i+1<children();i++) {
+            const int b=pane_pos(child(i))+pane_size(child(i));
+            if (m>=b && m<b+bar_size) return i;
+        }
+        return -1;
+    }
+
+public:
+    static const int HORIZONTAL=0,VERTICAL=1;
+    int bar_size=6;             // gap between panes
+    int min_pane=10;            // panes can not be dragged smaller than this
+
+    Splitter(int X,int Y,int W,int H,const char *L=0) : Fl_Group(X,Y,W,H,L) {
+        type(HORIZONTAL);
+        resizable(NULL); // we do our own layout
+    }
+    virtual ~Splitter() { }
+
+    void layout() { // position panes from ratios
+        const int n=children();
+        if ((int)ratios.size()!=n) {
+            if (ratios_pending && (int)ratios.size()>n) return; // set before the panes were added
+            ratios_from_panes();
+        }
+        ratios_pending=false;
+        const int start=horizontal() ? x() : y(),space=avail();
+        std::vector<int> sizes(n);
+        double cum=0;
+        int p=0;
+        for (int i=0;i<n;i++) {
+            cum+=ratios[i];
+            const int end= i==n-1 ? space : (int)(cum*space+0.5); // from the cumulative ratio => no drift
+            sizes[i]=end-p>0 ? end-p : 0;
+            p+=sizes[i];
+        }
+        // panes below min_pane get what they lack from the others, in proportion to what those have above it.
+        // the ratios stay => growing the splitter again restores them
+        const int floor=n && space>0 ? std::min(min_pane,space/n) : 0;
+        int lack=0,excess=0;
+        for (auto s : sizes) 
+            if (s<floor) lack+=floor-s; else excess+=s-floor;
+        if (lack) {
+            int taken=0;
+            for (auto &s : sizes) 
+                if (s>floor) {
+                    const int t=(int)((long long)(s-floor)*lack/excess);
+                    s-=t;
+                    taken+=t;
+                }
+            for (auto &s : sizes) {
+                if (s<floor) s=floor;
+                else if (taken<lack && s>floor) { s--; taken++; } // rounding
+            }
+        }
+        p=start;
+        for (int i=0;i<n;i++) {
+            set_pane(child(i),p,sizes[i]);
+            p+=sizes[i]+bar_size;
+        }
+    }
+
+    std::string get_ratios() const {
+        std::string out;
+        char buf[32];
+        for (auto r : ratios) {
+            snprintf(buf,sizeof(buf),"%.17g",r); // exact => layout files round trip
+            if (!out.empty()) out+=';';
+            out+=buf;
+        }
+        return out;
+    }
+    void set_ratios(const std::string &val) {
+        ratios.clear();
+        for (auto &r : split(val,';')) ratios.push_back(atof(r.c_str()));
+        normalize();
+        ratios_pending=(int)ratios.size()!=children();
+        if (!ratios_pending) layout();
+        redraw();
+    }
+
+    // Fl_Group's are not virtual: panes added or removed through an Fl_Group* need layout() afterwards
+    void insert(Fl_Widget &o,int index) { 
+        const int from= o.parent()==this ? find(o) : -1; // >=0 => a pane moves
+        Fl_Group::insert(o,index); 
+        const int to=find(o);
+        if (from<0) 
+            pane_added(to);
+        else if (!ratios_pending && (int)ratios.size()==children() && from!=to) {
+            const double r=ratios[from];
+            ratios.erase(ratios.begin()+from);
+            ratios.insert(ratios.begin()+to,r);
+        }
+        layout();
+    }
+    void insert(Fl_Widget &o,Fl_Widget *before) { insert(o,find(before)); }
+    void add(Fl_Widget &o) { insert(o,children()); }
+    void add(Fl_Widget *o) { add(*o); }
+    void remove(int index) {
+        if (index<0 || index>=children()) return;
+        Fl_Group::remove(index);
+        if (!ratios_pending && index<(int)ratios.size()) {
+            ratios.erase(ratios.begin()+index);
+            normalize();
+        }
+        layout();
+        redraw();
+    }
+    void remove(Fl_Widget &o) { remove(find(o)); }
+    void remove(Fl_Widget *o) { remove(*o); }
+
+    virtual void resize(int X,int Y,int W,int H) {
+        Fl_Widget::resize(X,Y,W,H);
+        layout();
+    }
+
+    void draw_bars() {
+        for (int i=0;i+1<children();i++) {
+            const int b=pane_pos(child(i))+pane_size(child(i));
+            if (horizontal())
+                fl_draw_box(FL_FLAT_BOX,b,y(),bar_size,h(),color());
+            else
+                fl_draw_box(FL_FLAT_BOX,x(),b,w(),bar_size,color());
+        }
+    }
+
+    virtual void draw() {
+        Fl_Group::draw(); // only redraws damaged panes unless we are fully damaged
+        draw_bars();
+    }
+
+    virtual int handle(int e) {
+        switch (e) {
+            case FL_ENTER:
+            case FL_MOVE: {
+                const int bar=bar_at(Fl::event_x(),Fl::event_y());
+                if (bar>=0) {
+                    fl_cursor(horizontal() ? FL_CURSOR_WE : FL_CURSOR_NS);
+                    return 1;
+                }
+                fl_cursor(FL_CURSOR_DEFAULT);
+                break;
+            }
+            case FL_LEAVE:
+                fl_cursor(FL_CURSOR_DEFAULT);
+                break;
+            case FL_PUSH: {
+                drag_bar=bar_at(Fl::event_x(),Fl::event_y());
+                if (drag_bar<0) break;
+                // the only panes affected by this drag are the two next to the bar
+                drag_start=horizontal() ? Fl::event_x() : Fl::event_y();
+                drag_size1=pane_size(child(drag_bar));
+                drag_size2=pane_size(child(drag_bar+1));
+                if ((int)ratios.size()!=children()) ratios_from_panes();
+                return 1;
+            }
+            case FL_DRAG: {
+                if (drag_bar<0) break;
+                int diff=(horizontal() ? Fl::event_x() : Fl::event_y())-drag_start;
+                if (drag_size1+diff<min_pane) diff=min_pane-drag_size1;
+                if (drag_size2-diff<min_pane) diff=drag_size2-min_pane;
+                const int s1=drag_size1+diff,s2=drag_size2-diff;
+                Fl_Widget *p1=child(drag_bar),*p2=child(drag_bar+1);
+                if (s1!=pane_size(p1)) {
+                    set_pane(p1,pane_pos(p1),s1);
+                    set_pane(p2,pane_pos(p1)+s1+bar_size,s2);
+                    const double pair=ratios[drag_bar]+ratios[drag_bar+1];
+                    ratios[drag_bar]=s1+s2 ? pair*s1/(s1+s2) : pair/2;
+                    ratios[drag_bar+1]=pair-ratios[drag_bar];
+                    p1->redraw(); // rest of the splitter is untouched
+                    p2->redraw();
+                }
+                return 1;
+            }
+            case FL_RELEASE:
+                if (drag_bar<0) break;
+                drag_bar=-1;
+                do_callback();
+                return 1;
+            default:
+                break;
+        }
+        return Fl_Group::handle(e);
+    }
+};
+
+} // namespace fltklayout
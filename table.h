@@ -2,34 +2,71 @@
 
 #include <string>
 #include <vector>
-#include <deque>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <set>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <FL/Fl.H>
 #include <FL/Fl_Table.H>
 #include <FL/fl_draw.H>
 
 namespace fltklayout {
 
-struct StringTable : public Fl_Table {
+struct StringTable;
+
+// the rows, columns and cells of a table without the widget: headers, column storage and everything that
+// fills them (add_row()/setText(), upsert(), apply_snapshot(), import_csv(), load_state()...).
+// StringTable is a TableData on screen, TableModel one that any number of StringTables show.
+// every change is reported through the hooks below
+struct TableData {
+
+   // what a column stores: text, binary numbers that are only formatted when drawn, codes into a
+   // per column dictionary of the distinct texts (COLUMN_DICT, for symbol/side/venue/status...)
+   // or the recent history of a number, drawn as a sparkline (COLUMN_SPARKLINE)
+   enum ColumnType { COLUMN_TEXT=0,COLUMN_INT64=1,COLUMN_DOUBLE=2,COLUMN_PRICE=3,COLUMN_TIMESTAMP=4,COLUMN_DICT=5,COLUMN_SPARKLINE=6 };
+   struct ColumnFormat {
+       int type;
+       int precision;          // decimals, -1 => COLUMN_DOUBLE/SPARKLINE %.10g, COLUMN_PRICE from the tick, COLUMN_TIMESTAMP whole seconds
+       double tick;            // COLUMN_PRICE: values are whole ticks
+       std::string format;     // COLUMN_INT64/COLUMN_DOUBLE: printf format, COLUMN_TIMESTAMP: strftime format (local time)
+       int history;            // COLUMN_SPARKLINE: values kept per cell (2..65535)
+
+       ColumnFormat(int type=COLUMN_TEXT,int precision=-1,double tick=0.01,const std::string &format=std::string(),int history=64)
+       : type(type),precision(precision),tick(tick),format(format),history(history)
+       { }
+   };
 
    struct Header {
-       StringTable &table;
+       TableData &table;
        std::string name,label;
        Fl_Align column_header_align;
        Fl_Align column_data_align;
+       ColumnFormat column_format;
 
-       Header(StringTable &table,const bool is_column,const std::string &name,const std::string &label)
+       Header(TableData &table,const bool is_column,const std::string &name,const std::string &label)
        : table(table),name(name),label(label),column_header_align(FL_ALIGN_CENTER),column_data_align(FL_ALIGN_CENTER)
        { }
        virtual ~Header() { }
 
        virtual void set_label(const std::string &_label) { label=_label; }
-       virtual void draw(int X,int Y,int W,int H) {
-           fl_push_clip(X,Y,W,H);
-           fl_draw_box(FL_THIN_UP_BOX,X,Y,W,H,table.row_header_color());
-           fl_color(FL_BLACK);
-           fl_draw(label.c_str(),X,Y,W,H,column_header_align);
-           fl_pop_clip();
-       }
+       virtual void draw(int X,int Y,int W,int H) { table.draw_header(label.c_str(),column_header_align,X,Y,W,H); }
    };
 
    virtual Header *header_factory(const bool is_column,const std::string &name,const std::string &label) {
@@ -37,15 +74,182 @@ struct StringTable : public Fl_Table {
    }
    virtual void delete_header(Header *h) { delete h; }
 
+   // order of the entries on screen, kept as an implicit treap with one node per data idx:
+   // insert/erase/move and both position<->data idx lookups are O(log n)
+   struct ViewIndex {
+       struct Node {
+           int left=-1,right=-1,parent=-1;
+           int count=0;          // nodes in this subtree, 0 => not in the view
+           uint32_t priority=0;
+       };
+       std::vector<Node> nodes;  // by data idx
+       int root=-1;
+       uint32_t seed=0x9e3779b9;
+
+       int count(const int n) const { return n<0 ? 0 : nodes[n].count; }
+       int size() const { return count(root); }
+       bool contains(const int DI) const { return DI>=0 && DI<(int)nodes.size() && nodes[DI].count; }
+
+       int at(int pos) const { // data idx at a position
+           if (pos<0 || pos>=size()) return -1;
+           int n=root;
+           for (;;) {
+               const int l=count(nodes[n].left);
+               if (pos<l) n=nodes[n].left;
+               else if (pos==l) return n;
+               else { pos-=l+1; n=nodes[n].right; }
+           }
+       }
+       int position(int DI) const { // position of a data idx, -1 if not in the view
+           if (!contains(DI)) return -1;
+           int pos=count(nodes[DI].left);
+           for (int p=nodes[DI].parent;p>=0;DI=p,p=nodes[p].parent)
+               if (nodes[p].right==DI) pos+=count(nodes[p].left)+1;
+           return pos;
+       }
+
+       template<class Less> int lower_bound(Less less) const { // first position whose entry is not less(entry), for sorted views
+           int pos=0;
+           for (int n=root;n>=0;) {
+               if (less(n)) { pos+=count(nodes[n].left)+1; n=nodes[n].right; }
+               else n=nodes[n].left;
+           }
+           return pos;
+       }
+
+       void insert(int pos,const int DI) {
+           if (DI>=(int)nodes.size()) nodes.resize(DI+1);
+           if (contains(DI)) erase(DI);
+           Node &n=nodes[DI];
+           n.left=n.right=n.parent=-1;
+           n.count=1;
+           seed^=seed<<13; seed^=seed>>17; seed^=seed<<5; // xorshift
+           n.priority=seed;
+           pos=std::max(0,std::min(pos,size()));
+           int a,b;
+           split(root,pos,a,b);
+           root=merge(merge(a,DI),b);
+           nodes[root].parent=-1;
+       }
+       void push_back(const int DI) { insert(size(),DI); }
+       void erase(const int DI) {
+           if (!contains(DI)) return;
+           Node &n=nodes[DI];
+           const int p=n.parent,m=merge(n.left,n.right);
+           if (m>=0) nodes[m].parent=p;
+           if (p<0) root=m;
+           else {
+               if (nodes[p].left==DI) nodes[p].left=m; else nodes[p].right=m;
+               for (int q=p;q>=0;q=nodes[q].parent) nodes[q].count--;
+           }
+           n.left=n.right=n.parent=-1;
+           n.count=0;
+       }
+       void clear() { nodes.clear(); root=-1; }
+       void assign(const std::vector<int> &order) { // O(n): built along its right spine as a cartesian tree of the priorities
+           clear();
+           int last_DI=-1;
+           for (auto DI : order) last_DI=std::max(last_DI,DI);
+           nodes.resize(last_DI+1);
+           std::vector<int> spine;
+           for (auto DI : order) {
+               Node &n=nodes[DI];
+               seed^=seed<<13; seed^=seed>>17; seed^=seed<<5;
+               n.priority=seed;
+               n.right=n.parent=-1;
+               n.left=-1;
+               while (!spine.empty() && nodes[spine.back()].priority<n.priority) {
+                   n.left=spine.back();
+                   spine.pop_back();
+               }
+               if (!spine.empty()) nodes[spine.back()].right=DI;
+               spine.push_back(DI);
+           }
+           if (spine.empty()) return;
+           root=spine[0];
+           std::vector<int> preorder,stack(1,root); // children after their parent => pull() in reverse
+           preorder.reserve(order.size());
+           while (!stack.empty()) {
+               const int n=stack.back();
+               stack.pop_back();
+               preorder.push_back(n);
+               if (nodes[n].left>=0) stack.push_back(nodes[n].left);
+               if (nodes[n].right>=0) stack.push_back(nodes[n].right);
+           }
+           for (auto i=preorder.rbegin();i!=preorder.rend();++i) pull(*i);
+           nodes[root].parent=-1;
+       }
+       std::vector<int> to_vector() const { // in view order
+           std::vector<int> out,stack;
+           out.reserve(size());
+           for (int n=root;n>=0 || !stack.empty();) {
+               if (n>=0) { stack.push_back(n); n=nodes[n].left; continue; }
+               n=stack.back(); stack.pop_back();
+               out.push_back(n);
+               n=nodes[n].right;
+           }
+           return out;
+       }
+
+   private:
+       void pull(const int n) {
+           Node &x=nodes[n];
+           x.count=1+count(x.left)+count(x.right);
+           if (x.left>=0) nodes[x.left].parent=n;
+           if (x.right>=0) nodes[x.right].parent=n;
+       }
+       void split(const int t,const int k,int &a,int &b) { // first k entries of t => a, rest => b
+           if (t<0) { a=b=-1; return; }
+           const int l=count(nodes[t].left);
+           if (l<k) {
+               int r;
+               split(nodes[t].right,k-l-1,r,b);
+               nodes[t].right=r;
+               a=t;
+           } else {
+               int l2;
+               split(nodes[t].left,k,a,l2);
+               nodes[t].left=l2;
+               b=t;
+           }
+           pull(t);
+           if (a>=0) nodes[a].parent=-1;
+           if (b>=0) nodes[b].parent=-1;
+       }
+       int merge(const int a,const int b) {
+           if (a<0) return b;
+           if (b<0) return a;
+           if (nodes[a].priority>nodes[b].priority) {
+               nodes[a].right=merge(nodes[a].right,b);
+               pull(a);
+               return a;
+           }
+           nodes[b].left=merge(a,nodes[b].left);
+           pull(b);
+           return b;
+       }
+   };
+
    struct Headers {
        std::vector<Header*> headers;
-       std::map<std::string,int> name2idx;
-       std::vector<int> view,reverse_view;
+       std::unordered_map<std::string,int> name2idx;
+       ViewIndex view;
+       std::vector<int> free_slots; // slots of removed entries (headers[DI]==NULL), reused by add()
+       int source_size=-1;   // >=0 => entries come from a DataSource and have no Header
+       bool indexed=true;    // false => no view index, screen idx == data idx
 
-       int get_idx(const std::string &name) { // idx in data[]
+       int slot_count() { return source_size>=0 ? source_size : headers.size(); }
+       int size() { return indexed ? view.size() : slot_count(); } // entries on screen
+
+       int get_idx(const std::string &name) { // data idx (column slot)
            auto i=name2idx.find(name);
            return i==name2idx.end() ? -1 : i->second;
        }
+       void reserve(const size_t n) { // room for n entries in total
+           headers.reserve(n);
+           name2idx.reserve(n);
+           view.nodes.reserve(n);
+       }
        int get_view(const std::string &name) { // idx on screen
            int idx=get_idx(name);
            return idx>=0 ? idx2view(idx) : -1;
@@ -53,54 +257,95 @@ struct StringTable : public Fl_Table {
        Header *get_header(const int N) { 
            return N>=0 && N<(int)headers.size() ? headers[N] : NULL;
        }
-       int view2idx(const int I) { // convert screen idx to data[] idx
-           return I>=0 && I<(int)view.size() ? view[I] : -1;
+       int view2idx(const int I) { // convert screen idx to data idx
+           if (!indexed) return I>=0 && I<slot_count() ? I : -1;
+           return view.at(I);
        }
-       int idx2view(const int DI) { // convert data[] idx to screen idx
-           return DI>=0 && DI<(int)reverse_view.size() ? reverse_view[DI] : -1;
-       }
-       void set_reverse_view() {
-           reverse_view.resize(headers.size());
-           std::fill(reverse_view.begin(),reverse_view.end(),-1);
-           for (int i=0;i<(int)view.size();i++)
-               reverse_view[view[i]]=i;
+       int idx2view(const int DI) { // convert data idx to screen idx
+           if (!indexed) return DI>=0 && DI<slot_count() ? DI : -1;
+           return view.position(DI);
        }
        void set_view(const std::vector<int> &new_view) { 
-           view=new_view; 
-           set_reverse_view();
+           indexed=true;
+           view.assign(new_view);
        }
-       void view_remove(const int DI) {
-           int VI=reverse_view[DI];
-           if (VI>=0) {
-               view.erase(view.begin()+VI);
-               for (auto &i : view) {
-                   if (i>=DI) i--;
-               }
-               reverse_view.erase(reverse_view.begin()+DI);
-               for (int c=DI;c<(int)reverse_view.size();c++) {
-                   if (reverse_view[c]>=VI) reverse_view[c]--;
-               }
+       void clear_view() { // show all entries in data order without keeping an index
+           indexed=false;
+           view.clear();
+       }
+       void view_remove(const int DI) { // DI no longer on screen, data idx of other entries unchanged
+           if (indexed) view.erase(DI);
+       }
+       void view_insert(const int VI,const int DI) { // (re)position DI on screen
+           if (indexed) view.insert(VI,DI);
+       }
+
+       int add(Header *h,const bool to_view=true) { // new entry at the end of the view, returns its data idx
+           int DI;
+           if (!free_slots.empty()) {
+               DI=free_slots.back();
+               free_slots.pop_back();
+               headers[DI]=h;
+           } else {
+               DI=headers.size();
+               headers.push_back(h);
+           }
+           name2idx[h->name]=DI;
+           if (indexed && to_view) view.push_back(DI);
+           return DI;
+       }
+       Header *release(const int DI) { // remove an entry but keep its slot for reuse => O(1) apart from the view
+           view_remove(DI);
+           Header *h=headers[DI];
+           name2idx.erase(h->name);
+           headers[DI]=NULL;
+           free_slots.push_back(DI);
+           return h;
+       }
+       Header *erase(const int DI) { // remove an entry, later entries move down one data idx
+           view_remove(DI);
+           if (indexed) { // renumbers everything after DI => rebuild, only used for the few columns
+               std::vector<int> order=view.to_vector();
+               for (auto &i : order) 
+                   if (i>DI) i--;
+               view.assign(order);
+           }
+           Header *h=headers[DI];
+           headers.erase(headers.begin()+DI);
+           name2idx.erase(h->name);
+           for (auto &i : name2idx) 
+               if (i.second>DI) --i.second;
+           return h;
+       }
+       bool compact_due() const { return free_slots.size()>=1024 && free_slots.size()*2>headers.size(); }
+       std::vector<int> compact() { // drop free slots, returns the old data idx of every new one
+           std::vector<int> old_idx,new_idx(headers.size(),-1);
+           old_idx.reserve(headers.size()-free_slots.size());
+           for (int i=0;i<(int)headers.size();i++) {
+               if (!headers[i]) continue;
+               new_idx[i]=old_idx.size();
+               headers[old_idx.size()]=headers[i];
+               old_idx.push_back(i);
            }
+           headers.resize(old_idx.size());
+           free_slots.clear();
+           for (auto &i : name2idx) i.second=new_idx[i.second];
+           if (indexed) {
+               std::vector<int> order=view.to_vector();
+               for (auto &i : order) i=new_idx[i];
+               view.assign(order);
+           }
+           return old_idx;
+       }
+       void clear() {
+           headers.clear();
+           name2idx.clear();
+           view.clear();
+           free_slots.clear();
        }
    };
    Headers column_headers,row_headers;
 
-   void set_column_view(const std::vector<int> &new_view) {
-       column_headers.set_view(new_view);
-       set_cols();
-   }
-   void set_row_view(const std::vector<int> &new_view) {
-       row_headers.set_view(new_view);
-       set_rows();
-   }
-
-   void set_cols() { cols(column_headers.view.size()); }
-   void set_rows() {
-       int old=rows();
-       rows(row_headers.view.size());
-       if (!old) row_height_all(default_row_height);
-   }
-
    struct Cell {
        Cell() { }
        virtual ~Cell() { }
@@ -113,62 +358,1000 @@ struct StringTable : public Fl_Table {
         std::string _text;
         Header &row_header,&column_header;
 
-        TextCell(StringTable &table,Header &row_header,Header &column_header)
+        TextCell(TableData &table,Header &row_header,Header &column_header)
         : row_header(row_header),column_header(column_header)
         { }
         virtual ~TextCell() { }
 
         virtual std::string text() override { return _text; }
         virtual void text(const std::string &new_text) override { _text=new_text; }
-        virtual void draw(StringTable &table,int DR,int DC,int R,int C,int X,int Y,int W,int H) override {
-            fl_push_clip(X,Y,W,H);
-            int R1,C1,R2,C2;
-            table.get_selection(R1,C1,R2,C2);
-            Fl_Color bg= (R>=R1 && C>=C1 && R<=R2 && C<=C2) ? FL_CYAN : FL_WHITE;
-            fl_color(bg); fl_rectf(X,Y,W,H); 
-            fl_color(FL_GRAY0); fl_draw(_text.c_str(),X,Y,W,H,column_header.column_data_align);
-            fl_color(table.color()); fl_rect(X,Y,W,H);
-            fl_pop_clip();
-        }
+        virtual void draw(StringTable &table,int DR,int DC,int R,int C,int X,int Y,int W,int H) override; // after StringTable
     };
     virtual Cell *cell_factory(Header &row_header,Header &column_header) {
         return new TextCell(*this,row_header,column_header);
     }
     virtual void delete_cell(Cell *c) { delete c; }
-    std::deque<std::vector<Cell*>> data;
 
-    Cell *cell(const int DR,const int DC) { return data[DR][DC]; }
+    // save_state()/load_state() files: sections start 8 byte aligned, arrays of cells are stored as is
+    // so loading is a copy out of the mapped file
+    enum StateKind { STATE_TEXTS=0,STATE_VALUES=1,STATE_DICT=2,STATE_SERIES=3 };
+    struct StateWriter {
+        std::FILE *f;
+        uint64_t pos=0;
+
+        StateWriter(std::FILE *f) : f(f) { }
+        void put(const void *p,const size_t n) { fwrite(p,1,n,f); pos+=n; }
+        template<class T> void put(const T v) { put(&v,sizeof(v)); }
+        void align() { static const char zero[8]={0}; put(zero,(8-pos%8)%8); }
+        void string(const std::string &s) { put((uint32_t)s.size()); put(s.data(),s.size()); }
+        template<class T> void array(const std::vector<T> &v) {
+            put((uint64_t)v.size()); align();
+            put(v.data(),v.size()*sizeof(T)); align();
+        }
+        template<class F> void texts(const size_t n,F text) { // offsets then the '\0' terminated texts, text(i) => const char*
+            std::vector<uint64_t> offsets(n+1,0);
+            for (size_t i=0;i<n;i++) offsets[i+1]=offsets[i]+strlen(text(i))+1;
+            array(offsets);
+            for (size_t i=0;i<n;i++) {
+                const char *t=text(i);
+                put(t,strlen(t)+1);
+            }
+            align();
+        }
+    };
+    struct StateReader {
+        const char *start,*p,*end;
+        bool ok=true;
+
+        StateReader(const char *data,const size_t size) : start(data),p(data),end(data+size) { }
+        const char *get(const size_t n) {
+            if (!ok || (size_t)(end-p)<n) { ok=false; return NULL; }
+            const char *r=p;
+            p+=n;
+            return r;
+        }
+        template<class T> T get() {
+            T v=T();
+            const char *s=get(sizeof(T));
+            if (s) memcpy(&v,s,sizeof(T));
+            return v;
+        }
+        template<class T> T peek() const {
+            T v=T();
+            if (ok && (size_t)(end-p)>=sizeof(T)) memcpy(&v,p,sizeof(T));
+            return v;
+        }
+        void align() { get((8-(p-start)%8)%8); }
+        std::string string() {
+            const uint32_t n=get<uint32_t>();
+            const char *s=get(n);
+            return s ? std::string(s,n) : std::string();
+        }
+        template<class T> bool array(std::vector<T> &v,const size_t expected) {
+            const uint64_t n=get<uint64_t>();
+            align();
+            if (n!=expected) ok=false;
+            const char *s=get(n*sizeof(T));
+            align();
+            if (!ok) return false;
+            v.resize(n);
+            if (n) memcpy(&v[0],s,n*sizeof(T));
+            return true;
+        }
+        bool texts(const size_t n,std::vector<uint64_t> &offsets,const char *&blob) { // text i is blob+offsets[i]
+            if (!array(offsets,n+1)) return false;
+            for (size_t i=0;i<n;i++) 
+                if (offsets[i+1]<=offsets[i]) ok=false;
+            blob=get(offsets[n]);
+            align();
+            if (!ok) return false;
+            for (size_t i=0;i<n;i++) 
+                if (blob[offsets[i+1]-1]) return ok=false;
+            return true;
+        }
+    };
+
+    // storage for one data column, one slot per data row (DR).
+    // cells are not objects of their own: a column stores its values however it likes and draws them
+    // itself, so there is one virtual call per cell instead of one heap object per cell
+    struct Column {
+        // Cell interface onto one slot of a column, returned by cell() so callers can keep using
+        // cell(DR,DC)->text(). made on first use and kept per slot => valid like a cell_factory() cell,
+        // until the row is removed or the column is replaced by a format of another type
+        struct ProxyCell : public Cell {
+            Column &column;
+            int DR;
+
+            ProxyCell(Column &column,const int DR) : column(column),DR(DR) { }
+            virtual ~ProxyCell() { }
+
+            virtual std::string text() override { return column.text(DR); }
+            virtual void text(const std::string &new_text) override { column.text(DR,new_text); }
+            virtual void draw(StringTable &table,int DR,int DC,int R,int C,int X,int Y,int W,int H) override; // after StringTable
+        };
+
+        TableData &table;   // the table storing it. a TableModel lends its columns to its views, which draw them
+        Header &header;
+        std::vector<std::unique_ptr<ProxyCell> > proxies; // by DR, only for cells someone asked for
+
+        Column(TableData &table,Header &header) : table(table),header(header) { }
+        virtual ~Column() { }
+
+        virtual void resize(const int rows)=0;    // slots added at the end / removed from the end
+        virtual void clear_slot(const int DR)=0;  // row removed, the slot will be reused by another row
+        virtual void init_slot(const int DR) { }  // free slot reused by a new row
+        virtual void reserve(const int rows,const size_t text_bytes) { } // room for bulk loads
+        virtual void remap(const std::vector<int> &old_slot)=0; // slots renumbered, new slot i was old_slot[i]
+        virtual std::string text(const int DR)=0;
+        virtual void text(const int DR,const std::string &new_text)=0;
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) { view.draw_text(text(DR).c_str(),header.column_data_align,R,C,X,Y,W,H); } // view: the table drawing it
+        virtual Cell *cell(const int DR) {
+            if (DR>=(int)proxies.size()) proxies.resize(DR+1);
+            if (!proxies[DR]) proxies[DR].reset(new ProxyCell(*this,DR));
+            return proxies[DR].get();
+        }
+        void remap_proxies(const std::vector<int> &old_slot) { // next to remap(), proxies stay with their rows
+            if (proxies.empty()) return;
+            std::vector<std::unique_ptr<ProxyCell> > moved(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) 
+                if (old_slot[i]<(int)proxies.size() && (moved[i]=std::move(proxies[old_slot[i]]))) moved[i]->DR=i;
+            proxies.swap(moved);
+        }
+        virtual bool number(const int DR,double &out) { return parse_number(text(DR).c_str(),out); } // for numeric sort/filter
+        virtual const char *text_ptr(const int DR,std::string &tmp) { tmp=text(DR); return tmp.c_str(); } // valid until the column changes
+        virtual bool plain_text() const { return false; } // true => cells are just text_ptr(), drawn in row batches by the table
+        virtual int text_width(TableData &view,const int DR) { std::string tmp; return view.measure_text(text_ptr(DR,tmp)); } // <0 => needs fl_draw() layout
+        virtual int compare(const int DR1,const int DR2) { return text(DR1).compare(text(DR2)); } // lexical
+        virtual bool typed() const { return false; } // true => values are binary numbers, compare() orders them by value
+        virtual bool concurrent_reads() const { return false; } // true => text_ptr()/number()/compare()/equals() of different slots can run in parallel threads
+        virtual void format_changed() { }         // header.column_format changed but not the type
+        virtual void prepare_sort() { }           // before compare() runs in several threads
+        virtual void format_number(const double v,char *out,const size_t size) { snprintf(out,size,"%.10g",v); } // totals
+        virtual bool equals(const int DR,const std::string &text) { std::string tmp; return text==text_ptr(DR,tmp); } // storing text would not change the cell
+        virtual int code(const int DR) const { return -1; }                // COLUMN_DICT: code of the cell
+        virtual void save_cells(StateWriter &w,const std::vector<int> &DRs) { // the slots in file order, default: texts
+            w.put((uint32_t)STATE_TEXTS);
+            std::string tmp;
+            w.texts(DRs.size(),[&](size_t i){ return text_ptr(DRs[i],tmp); });
+        }
+        virtual bool load_cells(StateReader &r,const int rows) { // into slots 0..rows-1, false => not a section this column can read
+            if (r.get<uint32_t>()!=STATE_TEXTS) return false;
+            std::vector<uint64_t> offsets;
+            const char *blob;
+            if (!r.texts(rows,offsets,blob)) return false;
+            for (int DR=0;DR<rows;DR++) 
+                text(DR,blob+offsets[DR]);
+            return true;
+        }
+        virtual int code(const std::string &text) const { return -2; }     // COLUMN_DICT: code of a text, -1 => not used, -2 => no dictionary
+        virtual void set_number(const int DR,const double v) { // value in display units (price, seconds)
+            char buf[32];
+            snprintf(buf,sizeof(buf),"%.10g",v);
+            text(DR,buf);
+        }
+        virtual void set_integer(const int DR,const int64_t v) { text(DR,std::to_string(v)); } // stored value (ticks, ns)
+    };
+    static bool parse_number(const char *text,double &out) { // whole text is a number (surrounding blanks allowed)
+        char *end;
+        out=strtod(text,&end);
+        if (end==text) return false;
+        while (*end==' ' || *end=='\t') end++;
+        return !*end;
+    }
+
+    // default column: all texts of the column back to back in one arena, '\0' terminated so they can be drawn in place
+    struct TextColumn : public Column {
+        std::string arena;
+        std::vector<uint32_t> offset,length;    // per slot
+        size_t garbage=0;                       // arena bytes no longer referenced
+        std::vector<int16_t> widths;            // per slot text width for the table font, -2 => not measured
+        int widths_serial=-1;                   // view.font_serial the widths are for
+
+        TextColumn(TableData &table,Header &header) : Column(table,header) { }
+        virtual ~TextColumn() { }
+
+        const char *c_str(const int DR) const { return arena.data()+offset[DR]; }
+
+        void compact() {
+            std::string new_arena;
+            new_arena.reserve(arena.size()-garbage);
+            for (size_t r=0;r<offset.size();r++) {
+                const uint32_t o=new_arena.size();
+                new_arena.append(arena,offset[r],length[r]+1);
+                offset[r]=o;
+            }
+            arena.swap(new_arena);
+            garbage=0;
+        }
+
+        virtual void resize(const int rows) override {
+            if (!rows) { 
+                arena.clear(); offset.clear(); length.clear(); widths.clear(); garbage=0; 
+                return;
+            }
+            for (int r=rows;r<(int)offset.size();r++) 
+                if (length[r]) garbage+=length[r]+1;
+            if (rows>(int)offset.size()) { // new slots share one empty string
+                const uint32_t empty=arena.size();
+                arena.push_back('\0');
+                offset.resize(rows,empty);
+            } else
+                offset.resize(rows);
+            length.resize(rows,0);
+        }
+        virtual void clear_slot(const int DR) override {
+            garbage+=length[DR];
+            offset[DR]+=length[DR]; // => its own terminator
+            length[DR]=0;
+            width_changed(DR);
+            maybe_compact();
+        }
+        virtual void remap(const std::vector<int> &old_slot) override {
+            std::vector<uint32_t> new_offset(old_slot.size()),new_length(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) {
+                new_offset[i]=offset[old_slot[i]];
+                new_length[i]=length[old_slot[i]];
+            }
+            offset.swap(new_offset);
+            length.swap(new_length);
+            widths.clear();
+            compact();
+        }
+        void maybe_compact() {
+            if (garbage>4096 && garbage>arena.size()/2) compact();
+        }
+        virtual std::string text(const int DR) override { return std::string(c_str(DR),length[DR]); }
+        virtual void text(const int DR,const std::string &new_text) override {
+            const uint32_t len=new_text.size();
+            width_changed(DR);
+            if (len<=length[DR]) { // fits in place (empty slots may share storage => never written)
+                if (!length[DR]) return;
+                memcpy(&arena[offset[DR]],new_text.c_str(),len+1);
+                garbage+=length[DR]-len;
+            } else {
+                if (length[DR]) garbage+=length[DR]+1;
+                offset[DR]=arena.size();
+                arena.append(new_text.c_str(),len+1);
+            }
+            length[DR]=len;
+            maybe_compact();
+        }
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) override { view.draw_text(c_str(DR),header.column_data_align,R,C,X,Y,W,H); }
+        virtual bool plain_text() const override { return true; }
+        virtual bool concurrent_reads() const override { return true; }
+        virtual int text_width(TableData &view,const int DR) override {
+            if (widths_serial!=view.font_serial) {
+                widths.assign(offset.size(),-2);
+                widths_serial=view.font_serial;
+            } else if (widths.size()<offset.size()) 
+                widths.resize(offset.size(),-2);
+            int16_t &w=widths[DR];
+            if (w==-2) w=view.measure_text(c_str(DR));
+            return w;
+        }
+        virtual void reserve(const int rows,const size_t text_bytes) override {
+            offset.reserve(rows);
+            length.reserve(rows);
+            arena.reserve(arena.size()+text_bytes);
+        }
+        void width_changed(const int DR) { if (DR<(int)widths.size()) widths[DR]=-2; }
+        virtual bool number(const int DR,double &out) override { return parse_number(c_str(DR),out); }
+        virtual const char *text_ptr(const int DR,std::string &tmp) override { return c_str(DR); }
+        virtual bool equals(const int DR,const std::string &text) override { return length[DR]==text.size() && !memcmp(c_str(DR),text.data(),text.size()); }
+        virtual bool load_cells(StateReader &r,const int rows) override { // the blob is the arena
+            if (r.get<uint32_t>()!=STATE_TEXTS) return false;
+            std::vector<uint64_t> offsets;
+            const char *blob;
+            if (!r.texts(rows,offsets,blob) || offsets[rows]>UINT32_MAX) return false;
+            arena.assign(blob,offsets[rows]);
+            offset.resize(rows);
+            length.resize(rows);
+            for (int DR=0;DR<rows;DR++) {
+                offset[DR]=offsets[DR];
+                length[DR]=offsets[DR+1]-offsets[DR]-1;
+            }
+            garbage=0;
+            widths.clear();
+            return true;
+        }
+        virtual int compare(const int DR1,const int DR2) override { return strcmp(c_str(DR1),c_str(DR2)); }
+    };
+
+    // COLUMN_INT64/DOUBLE/PRICE/TIMESTAMP: one binary value per slot, stores never allocate. the text is
+    // formatted when a cell is drawn (or read) and kept until the value changes
+    template<class T> struct TypedColumn : public Column {
+        struct Formatted {
+            int16_t width;      // for the table font, -2 => not measured
+            bool stale;
+            char text[29];
+        };
+        std::vector<T> values;
+        std::vector<uint8_t> present;           // 0 => empty cell
+        std::vector<Formatted> formatted;
+        int widths_serial=-1;                   // view.font_serial the widths are for
+
+        TypedColumn(TableData &table,Header &header) : Column(table,header) { }
+        virtual ~TypedColumn() { }
+
+        const ColumnFormat &format() const { return header.column_format; }
+        int price_decimals() const {
+            if (format().precision>=0) return format().precision;
+            int d=0;
+            for (double t=format().tick;d<9 && fabs(t-floor(t+0.5))>1e-9;t*=10) d++;
+            return d;
+        }
+        static char *format_int(char *end,int64_t v) { // digits backwards from end, returns the start
+            uint64_t u= v<0 ? 0-(uint64_t)v : v;
+            do { *--end='0'+u%10; u/=10; } while (u);
+            if (v<0) *--end='-';
+            return end;
+        }
+        void format_value(const T v,char *out,const size_t size) const {
+            const ColumnFormat &f=format();
+            switch (f.type) {
+                case COLUMN_INT64:
+                    if (!f.format.empty()) snprintf(out,size,f.format.c_str(),(long long)v);
+                    else {
+                        char buf[24];
+                        const char *p=format_int(buf+sizeof(buf),v);
+                        memcpy(out,p,buf+sizeof(buf)-p);
+                        out[buf+sizeof(buf)-p]='\0';
+                    }
+                    break;
+                case COLUMN_DOUBLE:
+                    if (!f.format.empty()) snprintf(out,size,f.format.c_str(),(double)v);
+                    else if (f.precision>=0) snprintf(out,size,"%.*f",f.precision,(double)v);
+                    else snprintf(out,size,"%.10g",(double)v);
+                    break;
+                case COLUMN_PRICE:
+                    snprintf(out,size,"%.*f",price_decimals(),(double)v*f.tick);
+                    break;
+                case COLUMN_TIMESTAMP: { // nanoseconds since the epoch
+                    const int64_t ns=(int64_t)v;
+                    time_t secs=ns/1000000000;
+                    int64_t frac=ns%1000000000;
+                    if (frac<0) { secs--; frac+=1000000000; }
+                    struct tm tm;
+                    localtime_r(&secs,&tm);
+                    size_t n=strftime(out,size,f.format.empty() ? "%H:%M:%S" : f.format.c_str(),&tm);
+                    const int digits=std::min(f.precision,9);
+                    if (digits>0 && n+digits+1<size) {
+                        for (int d=digits;d<9;d++) frac/=10;
+                        out[n++]='.';
+                        for (int d=digits-1;d>=0;d--,frac/=10) out[n+d]='0'+frac%10;
+                        n+=digits;
+                        out[n]='\0';
+                    }
+                    break;
+                }
+            }
+        }
+        bool parse(const char *text,T &v) const {
+            double d;
+            if (!parse_number(text,d)) return false;
+            switch (format().type) {
+                case COLUMN_INT64: v=(T)strtoll(text,NULL,10); break;
+                case COLUMN_PRICE: v=(T)llround(d/format().tick); break;
+                case COLUMN_TIMESTAMP: v=(T)llround(d*1e9); break; // seconds since the epoch
+                default: v=(T)d; break;
+            }
+            return true;
+        }
+        double to_number(const T v) const {
+            switch (format().type) {
+                case COLUMN_PRICE: return (double)v*format().tick;
+                case COLUMN_TIMESTAMP: return (double)v/1e9;
+                default: return (double)v;
+            }
+        }
+
+        void store(const int DR,const T v,const bool is_present) {
+            if (present[DR]==is_present && (!is_present || values[DR]==v)) return;
+            values[DR]=v;
+            present[DR]=is_present;
+            formatted[DR].stale=true;
+            formatted[DR].width=-2;
+        }
+        virtual void resize(const int rows) override {
+            values.resize(rows,T());
+            present.resize(rows,0);
+            formatted.resize(rows,Formatted{-2,true,{0}});
+        }
+        virtual void clear_slot(const int DR) override { store(DR,T(),false); }
+        virtual void reserve(const int rows,const size_t text_bytes) override {
+            values.reserve(rows);
+            present.reserve(rows);
+            formatted.reserve(rows);
+        }
+        virtual void remap(const std::vector<int> &old_slot) override {
+            std::vector<T> new_values(old_slot.size());
+            std::vector<uint8_t> new_present(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) {
+                new_values[i]=values[old_slot[i]];
+                new_present[i]=present[old_slot[i]];
+            }
+            values.swap(new_values);
+            present.swap(new_present);
+            formatted.assign(old_slot.size(),Formatted{-2,true,{0}});
+        }
+        const char *c_str(const int DR) {
+            Formatted &f=formatted[DR];
+            if (f.stale) {
+                if (present[DR]) format_value(values[DR],f.text,sizeof(f.text));
+                else f.text[0]='\0';
+                f.stale=false;
+            }
+            return f.text;
+        }
+        virtual std::string text(const int DR) override { return c_str(DR); }
+        virtual void text(const int DR,const std::string &new_text) override {
+            T v=T();
+            store(DR,v,parse(new_text.c_str(),v)); // not a number => empty
+        }
+        virtual void set_number(const int DR,const double v) override {
+            switch (format().type) {
+                case COLUMN_PRICE: store(DR,(T)llround(v/format().tick),true); break;
+                case COLUMN_TIMESTAMP: store(DR,(T)llround(v*1e9),true); break;
+                default: store(DR,(T)v,true); break;
+            }
+        }
+        virtual void set_integer(const int DR,const int64_t v) override { store(DR,(T)v,true); }
+        virtual bool equals(const int DR,const std::string &text) override { // same value even if formatted differently
+            T v=T();
+            const bool is_present=parse(text.c_str(),v);
+            return present[DR]==is_present && (!is_present || values[DR]==v);
+        }
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) override { view.draw_text(c_str(DR),header.column_data_align,R,C,X,Y,W,H); }
+        virtual bool plain_text() const override { return true; }
+        virtual bool concurrent_reads() const override { return true; }
+        virtual int text_width(TableData &view,const int DR) override {
+            if (widths_serial!=view.font_serial) {
+                for (auto &f : formatted) f.width=-2;
+                widths_serial=view.font_serial;
+            }
+            Formatted &f=formatted[DR];
+            if (f.width==-2) f.width=view.measure_text(c_str(DR));
+            return f.width;
+        }
+        virtual bool number(const int DR,double &out) override {
+            if (!present[DR]) return false;
+            out=to_number(values[DR]);
+            return true;
+        }
+        virtual const char *text_ptr(const int DR,std::string &tmp) override { return c_str(DR); }
+        virtual int compare(const int DR1,const int DR2) override { // empty cells after all values
+            if (!present[DR1] || !present[DR2]) return (int)present[DR2]-(int)present[DR1];
+            return values[DR1]<values[DR2] ? -1 : values[DR2]<values[DR1];
+        }
+        virtual bool typed() const override { return true; }
+        virtual void format_changed() override { formatted.assign(values.size(),Formatted{-2,true,{0}}); }
+        virtual void save_cells(StateWriter &w,const std::vector<int> &DRs) override {
+            std::vector<T> v(DRs.size());
+            std::vector<uint8_t> p(DRs.size());
+            for (size_t i=0;i<DRs.size();i++) { v[i]=values[DRs[i]]; p[i]=present[DRs[i]]; }
+            w.put((uint32_t)STATE_VALUES);
+            w.put((uint32_t)sizeof(T));
+            w.array(p);
+            w.array(v);
+        }
+        virtual bool load_cells(StateReader &r,const int rows) override {
+            if (r.get<uint32_t>()!=STATE_VALUES || r.get<uint32_t>()!=sizeof(T)) return false;
+            if (!r.array(present,rows) || !r.array(values,rows)) return false;
+            formatted.assign(rows,Formatted{-2,true,{0}});
+            return true;
+        }
+        virtual void format_number(const double v,char *out,const size_t size) override {
+            switch (format().type) {
+                case COLUMN_PRICE: snprintf(out,size,"%.*f",price_decimals(),v); break;
+                case COLUMN_TIMESTAMP: format_value((T)llround(v*1e9),out,size); break;
+                case COLUMN_DOUBLE: if (format().precision>=0) { snprintf(out,size,"%.*f",format().precision,v); break; } // fall through
+                default: snprintf(out,size,"%.10g",v); break;
+            }
+        }
+    };
+
+    // COLUMN_DICT: one code per slot into the distinct texts of the column, which are kept once with their
+    // number and width. sorting compares lexical ranks, equality filters compare codes.
+    // a code no cell uses any more is reused by the next new text. ranks are assigned by prepare_sort(),
+    // texts added since then compare as strings. more than table.dict_max_texts distinct texts => a
+    // dictionary saves nothing, the cells move into a TextColumn until the column is emptied
+    struct DictColumn : public Column {
+        std::vector<uint32_t> codes;                    // per slot
+        std::deque<std::string> texts;                  // per code, 0 => ""
+        std::unordered_map<std::string,uint32_t> index; // text => code
+        std::vector<uint32_t> uses;                     // per code, slots storing it (not counted for 0)
+        std::vector<uint32_t> free_codes;               // no longer used, for add()
+        std::vector<uint32_t> rank;                     // per code, position in lexical order, UINT32_MAX => not ranked yet
+        bool ranked=true;                               // every used code has a rank
+        std::vector<double> numbers;                    // per code, NAN => not a number
+        std::vector<int16_t> widths;                    // per code, -2 => not measured
+        int widths_serial=-1;
+        std::unique_ptr<TextColumn> plain;              // the cells after too many distinct texts
+
+        DictColumn(TableData &table,Header &header) : Column(table,header) { rebuild(std::vector<std::string>(1)); }
+        virtual ~DictColumn() { }
+
+        void rebuild(const std::vector<std::string> &new_texts) { // dictionary from scratch, code i => new_texts[i], then recount()
+            texts.assign(new_texts.begin(),new_texts.end());
+            index.clear();
+            numbers.clear();
+            uses.assign(texts.size(),0);
+            free_codes.clear();
+            rank.assign(texts.size(),UINT32_MAX);
+            ranked=false;
+            widths.assign(texts.size(),-2);
+            for (uint32_t c=0;c<texts.size();c++) {
+                index[texts[c]]=c;
+                double n;
+                numbers.push_back(parse_number(texts[c].c_str(),n) ? n : NAN);
+            }
+        }
+        void recount() { // uses from the slots, unused codes freed
+            std::fill(uses.begin(),uses.end(),0);
+            for (auto c : codes) 
+                if (c) uses[c]++;
+            free_codes.clear();
+            for (uint32_t c=texts.size();c-->1;) 
+                if (!uses[c]) drop(c);
+        }
+        uint32_t add(const std::string &text) { // new code, a free one if there is
+            uint32_t c;
+            if (free_codes.empty()) {
+                c=texts.size();
+                texts.push_back(text);
+                uses.push_back(0);
+                numbers.push_back(NAN);
+                widths.push_back(-2);
+                rank.push_back(UINT32_MAX);
+            } else {
+                c=free_codes.back();
+                free_codes.pop_back();
+                texts[c]=text;
+                widths[c]=-2;
+                rank[c]=UINT32_MAX;
+            }
+            index[text]=c;
+            double n;
+            numbers[c]=parse_number(text.c_str(),n) ? n : NAN;
+            ranked=false;
+            return c;
+        }
+        void drop(const uint32_t c) { // code unused, free for add()
+            auto i=index.find(texts[c]);
+            if (i!=index.end() && i->second==c) index.erase(i);
+            std::string().swap(texts[c]);
+            free_codes.push_back(c);
+        }
+        void release(const uint32_t c) { // a slot stops storing c
+            if (c && !--uses[c]) drop(c);
+        }
+        void to_plain() {
+            size_t bytes=0;
+            for (auto c : codes) bytes+=texts[c].size()+1;
+            plain.reset(new TextColumn(table,header));
+            plain->reserve(codes.size(),bytes);
+            plain->resize(codes.size());
+            for (size_t DR=0;DR<codes.size();DR++) 
+                if (codes[DR]) plain->text(DR,texts[codes[DR]]);
+            std::vector<uint32_t>().swap(codes);
+            rebuild(std::vector<std::string>(1));
+        }
+
+        virtual void prepare_sort() override { // lexical rank of every used code
+            if (plain || ranked) return;
+            std::vector<uint32_t> sorted;
+            sorted.reserve(texts.size()-free_codes.size());
+            for (uint32_t c=0;c<texts.size();c++) 
+                if (!c || uses[c]) sorted.push_back(c);
+            std::sort(sorted.begin(),sorted.end(),[this](uint32_t a,uint32_t b){ return texts[a]<texts[b]; });
+            for (size_t i=0;i<sorted.size();i++) rank[sorted[i]]=i;
+            ranked=true;
+        }
+        virtual void resize(const int rows) override {
+            if (plain && !rows) plain.reset(); // emptied => a dictionary again
+            if (plain) return plain->resize(rows);
+            for (size_t DR=rows;DR<codes.size();DR++) release(codes[DR]);
+            codes.resize(rows,0);
+        }
+        virtual void clear_slot(const int DR) override {
+            if (plain) return plain->clear_slot(DR);
+            release(codes[DR]);
+            codes[DR]=0;
+        }
+        virtual void reserve(const int rows,const size_t text_bytes) override { 
+            if (plain) plain->reserve(rows,text_bytes);
+            else codes.reserve(rows); 
+        }
+        virtual void remap(const std::vector<int> &old_slot) override {
+            if (plain) return plain->remap(old_slot);
+            std::vector<uint32_t> new_codes(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) new_codes[i]=codes[old_slot[i]];
+            codes.swap(new_codes);
+            recount(); // slots left out are gone
+        }
+        virtual std::string text(const int DR) override { return plain ? plain->text(DR) : texts[codes[DR]]; }
+        virtual void text(const int DR,const std::string &new_text) override {
+            if (plain) return plain->text(DR,new_text);
+            auto i=index.find(new_text);
+            uint32_t c;
+            if (i!=index.end()) 
+                c=i->second;
+            else if (texts.size()-free_codes.size()>=table.dict_max_texts) {
+                to_plain();
+                return plain->text(DR,new_text);
+            } else
+                c=add(new_text);
+            if (c) uses[c]++;
+            release(codes[DR]);
+            codes[DR]=c;
+        }
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) override { 
+            if (plain) plain->draw(view,DR,DC,R,C,X,Y,W,H);
+            else view.draw_text(texts[codes[DR]].c_str(),header.column_data_align,R,C,X,Y,W,H); 
+        }
+        virtual bool plain_text() const override { return true; }
+        virtual bool concurrent_reads() const override { return true; }
+        virtual int text_width(TableData &view,const int DR) override {
+            if (plain) return plain->text_width(view,DR);
+            if (widths_serial!=view.font_serial) {
+                widths.assign(texts.size(),-2);
+                widths_serial=view.font_serial;
+            }
+            int16_t &w=widths[codes[DR]];
+            if (w==-2) w=view.measure_text(texts[codes[DR]].c_str());
+            return w;
+        }
+        virtual bool number(const int DR,double &out) override {
+            if (plain) return plain->number(DR,out);
+            out=numbers[codes[DR]];
+            return out==out;
+        }
+        virtual const char *text_ptr(const int DR,std::string &tmp) override { return plain ? plain->text_ptr(DR,tmp) : texts[codes[DR]].c_str(); }
+        virtual bool equals(const int DR,const std::string &text) override { return plain ? plain->equals(DR,text) : texts[codes[DR]]==text; }
+        virtual int compare(const int DR1,const int DR2) override {
+            if (plain) return plain->compare(DR1,DR2);
+            const uint32_t r1=rank[codes[DR1]],r2=rank[codes[DR2]];
+            if (r1!=UINT32_MAX && r2!=UINT32_MAX) return (int)r1-(int)r2;
+            return texts[codes[DR1]].compare(texts[codes[DR2]]);
+        }
+        virtual int code(const int DR) const override { return plain ? -1 : (int)codes[DR]; }
+        virtual void save_cells(StateWriter &w,const std::vector<int> &DRs) override { // only the texts the slots use, renumbered
+            if (plain) return plain->save_cells(w,DRs);
+            std::vector<uint32_t> saved(texts.size(),UINT32_MAX),c(DRs.size()),used(1,0);
+            saved[0]=0;
+            for (size_t i=0;i<DRs.size();i++) {
+                uint32_t &s=saved[codes[DRs[i]]];
+                if (s==UINT32_MAX) {
+                    s=used.size();
+                    used.push_back(codes[DRs[i]]);
+                }
+                c[i]=s;
+            }
+            w.put((uint32_t)STATE_DICT);
+            w.put((uint32_t)used.size());
+            w.texts(used.size(),[this,&used](size_t i){ return texts[used[i]].c_str(); });
+            w.array(c);
+        }
+        virtual bool load_cells(StateReader &r,const int rows) override {
+            plain.reset();
+            rebuild(std::vector<std::string>(1));
+            codes.assign(rows,0);
+            if (r.peek<uint32_t>()==STATE_TEXTS) return Column::load_cells(r,rows); // saved after falling back
+            if (r.get<uint32_t>()!=STATE_DICT) return false;
+            const uint32_t n=r.get<uint32_t>();
+            std::vector<uint64_t> offsets;
+            const char *blob;
+            if (!n || !r.texts(n,offsets,blob)) return false;
+            std::vector<std::string> new_texts(n);
+            for (uint32_t i=0;i<n;i++) new_texts[i].assign(blob+offsets[i],offsets[i+1]-offsets[i]-1);
+            if (!new_texts[0].empty() || !r.array(codes,rows)) return false;
+            for (auto c : codes) 
+                if (c>=n) return false;
+            rebuild(new_texts);
+            recount();
+            if (texts.size()-free_codes.size()>table.dict_max_texts) to_plain();
+            return true;
+        }
+        virtual int code(const std::string &text) const override {
+            if (plain) return -2;
+            auto i=index.find(text);
+            return i==index.end() ? -1 : (int)i->second;
+        }
+    };
+
+    // COLUMN_SPARKLINE: the last format.history values of a number per cell, as one ring buffer for the
+    // whole column (slot DR owns samples[DR*history...]). set_number()/setNumber() append a value in O(1)
+    // without allocating, text(DR,...) appends a number and clears the cell for anything else.
+    // a cell draws as one polyline, min/max decimated to its width; its text, sort order, filters and
+    // totals are the last value
+    struct SparklineColumn : public Column {
+        int history=0;                      // samples per slot
+        std::vector<float> samples;         // rings, history per slot
+        std::vector<uint16_t> head,count;   // per slot: next sample written, samples kept
+        std::vector<double> last;           // per slot, exact last value
+
+        SparklineColumn(TableData &table,Header &header) : Column(table,header) { history=history_wanted(); }
+        virtual ~SparklineColumn() { }
+
+        int history_wanted() const { return std::max(2,std::min(65535,header.column_format.history)); }
+        int oldest(const int DR) const { return head[DR]>=count[DR] ? head[DR]-count[DR] : head[DR]-count[DR]+history; }
+        void append(const int DR,const double v) {
+            samples[(size_t)DR*history+head[DR]]=(float)v;
+            if (++head[DR]==history) head[DR]=0;
+            if (count[DR]<history) count[DR]++;
+            last[DR]=v;
+        }
+        template<class F> void for_each(const int DR,F f) const { // samples oldest first
+            const float *s=&samples[(size_t)DR*history];
+            for (int i=0,j=oldest(DR);i<count[DR];i++) {
+                f(i,s[j]);
+                if (++j==history) j=0;
+            }
+        }
+        void relayout(const int new_history) { // keeps the newest samples of every slot
+            std::vector<float> new_samples(head.size()*new_history);
+            for (size_t DR=0;DR<head.size();DR++) {
+                const int n=std::min((int)count[DR],new_history),skip=count[DR]-n;
+                float *out=&new_samples[DR*new_history];
+                for_each(DR,[&](int i,float v){ if (i>=skip) out[i-skip]=v; });
+                count[DR]=n;
+                head[DR]= n==new_history ? 0 : n;
+            }
+            samples.swap(new_samples);
+            history=new_history;
+        }
+
+        virtual void resize(const int rows) override {
+            samples.resize((size_t)rows*history);
+            head.resize(rows,0);
+            count.resize(rows,0);
+            last.resize(rows,0);
+        }
+        virtual void clear_slot(const int DR) override { head[DR]=count[DR]=0; }
+        virtual void reserve(const int rows,const size_t text_bytes) override {
+            samples.reserve((size_t)rows*history);
+            head.reserve(rows);
+            count.reserve(rows);
+            last.reserve(rows);
+        }
+        virtual void remap(const std::vector<int> &old_slot) override {
+            std::vector<float> new_samples(old_slot.size()*history);
+            std::vector<uint16_t> new_head(old_slot.size()),new_count(old_slot.size());
+            std::vector<double> new_last(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) {
+                memcpy(&new_samples[i*history],&samples[(size_t)old_slot[i]*history],history*sizeof(float));
+                new_head[i]=head[old_slot[i]];
+                new_count[i]=count[old_slot[i]];
+                new_last[i]=last[old_slot[i]];
+            }
+            samples.swap(new_samples);
+            head.swap(new_head);
+            count.swap(new_count);
+            last.swap(new_last);
+        }
+        virtual void format_changed() override { if (history_wanted()!=history) relayout(history_wanted()); }
+        virtual std::string text(const int DR) override {
+            if (!count[DR]) return std::string();
+            char buf[32];
+            format_number(last[DR],buf,sizeof(buf));
+            return buf;
+        }
+        virtual void text(const int DR,const std::string &new_text) override {
+            double v;
+            if (parse_number(new_text.c_str(),v)) append(DR,v);
+            else clear_slot(DR);
+        }
+        virtual void set_number(const int DR,const double v) override { append(DR,v); }
+        virtual void set_integer(const int DR,const int64_t v) override { append(DR,(double)v); }
+        virtual bool number(const int DR,double &out) override {
+            if (!count[DR]) return false;
+            out=last[DR];
+            return true;
+        }
+        virtual int compare(const int DR1,const int DR2) override { // empty cells after all values
+            if (!count[DR1] || !count[DR2]) return (int)(count[DR2]!=0)-(int)(count[DR1]!=0);
+            return last[DR1]<last[DR2] ? -1 : last[DR2]<last[DR1];
+        }
+        virtual bool typed() const override { return true; }
+        virtual bool concurrent_reads() const override { return true; }
+        virtual void format_number(const double v,char *out,const size_t size) override {
+            if (header.column_format.precision>=0) snprintf(out,size,"%.*f",header.column_format.precision,v);
+            else snprintf(out,size,"%.10g",v);
+        }
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) override {
+            fl_push_clip(X,Y,W,H);
+            fl_color(view.cell_background(DR,DC,R,C)); fl_rectf(X,Y,W,H);
+            const int n=count[DR],w=W-4,h=H-4; // 2 pixels of padding
+            if (n>1 && w>1 && h>1) {
+                float lo=last[DR],hi=lo;
+                for_each(DR,[&](int i,float v){ lo=std::min(lo,v); hi=std::max(hi,v); });
+                const double scale= hi>lo ? (h-1)/(double)(hi-lo) : 0;
+                const double top= hi>lo ? Y+2 : Y+2+(h-1)/2.0;
+                fl_color(view.sparkline_color);
+                fl_begin_line();
+                if (n<=w) // a vertex per sample
+                    for_each(DR,[&](int i,float v){ fl_vertex(X+2+(double)i*(w-1)/(n-1),top+(hi-v)*scale); });
+                else { // per pixel column its lowest and highest sample, in the order they came
+                    int x=0,end=n/w,lo_i=-1,hi_i=-1;
+                    float x_lo=0,x_hi=0;
+                    for_each(DR,[&](int i,float v){
+                        if (lo_i<0 || v<x_lo) { x_lo=v; lo_i=i; }
+                        if (hi_i<0 || v>x_hi) { x_hi=v; hi_i=i; }
+                        if (i+1<end) return;
+                        const double px=X+2+x;
+                        fl_vertex(px,top+(hi-(lo_i<hi_i ? x_lo : x_hi))*scale);
+                        if (lo_i!=hi_i) fl_vertex(px,top+(hi-(lo_i<hi_i ? x_hi : x_lo))*scale);
+                        x++;
+                        end=(int)((int64_t)(x+1)*n/w);
+                        lo_i=hi_i=-1;
+                    });
+                }
+                fl_end_line();
+            }
+            fl_color(view.grid_color()); fl_rect(X,Y,W,H);
+            fl_pop_clip();
+        }
+        virtual void save_cells(StateWriter &w,const std::vector<int> &DRs) override { // the rings as they are
+            std::vector<float> s(DRs.size()*history);
+            std::vector<uint16_t> h(DRs.size()),c(DRs.size());
+            std::vector<double> l(DRs.size());
+            for (size_t i=0;i<DRs.size();i++) {
+                memcpy(&s[i*history],&samples[(size_t)DRs[i]*history],history*sizeof(float));
+                h[i]=head[DRs[i]]; c[i]=count[DRs[i]]; l[i]=last[DRs[i]];
+            }
+            w.put((uint32_t)STATE_SERIES);
+            w.put((uint32_t)history);
+            w.array(h);
+            w.array(c);
+            w.array(l);
+            w.array(s);
+        }
+        virtual bool load_cells(StateReader &r,const int rows) override {
+            if (r.get<uint32_t>()!=STATE_SERIES || r.get<uint32_t>()!=(uint32_t)history) return false;
+            if (!r.array(head,rows) || !r.array(count,rows) || !r.array(last,rows) || !r.array(samples,(size_t)rows*history)) return false;
+            for (int DR=0;DR<rows;DR++) 
+                if (head[DR]>=history || count[DR]>history) return false;
+            return true;
+        }
+    };
+
+    // column of Cell objects from cell_factory(), for Cell subclasses that need per cell state
+    struct CellColumn : public Column {
+        std::vector<Cell*> cells;
+
+        CellColumn(TableData &table,Header &header) : Column(table,header) { }
+        virtual ~CellColumn() { resize(0); }
+
+        virtual void resize(const int rows) override {
+            for (int r=rows;r<(int)cells.size();r++)
+                if (cells[r]) table.delete_cell(cells[r]);
+            const int old=cells.size();
+            cells.resize(rows,NULL);
+            for (int r=old;r<rows;r++)
+                init_slot(r);
+        }
+        virtual void clear_slot(const int DR) override {
+            if (cells[DR]) table.delete_cell(cells[DR]);
+            cells[DR]=NULL;
+        }
+        virtual void init_slot(const int DR) override {
+            Header *row_header=table.row_headers.headers[DR];
+            if (row_header) cells[DR]=table.cell_factory(*row_header,header);
+        }
+        virtual void remap(const std::vector<int> &old_slot) override {
+            std::vector<Cell*> new_cells(old_slot.size());
+            for (size_t i=0;i<old_slot.size();i++) 
+                new_cells[i]=cells[old_slot[i]];
+            cells.swap(new_cells);
+        }
+        virtual std::string text(const int DR) override { return cells[DR]->text(); }
+        virtual void text(const int DR,const std::string &new_text) override { cells[DR]->text(new_text); }
+        virtual void draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) override; // after StringTable
+        virtual Cell *cell(const int DR) override { return cells[DR]; }
+    };
+
+    bool cell_objects=false; // true => new columns keep a Cell object per row made by cell_factory()
+    size_t dict_max_texts=65536; // COLUMN_DICT: more distinct texts => the column stores plain text
+    virtual Column *column_factory(Header &column_header) {
+        switch (column_header.column_format.type) {
+            case COLUMN_INT64:
+            case COLUMN_PRICE:
+            case COLUMN_TIMESTAMP: return new TypedColumn<int64_t>(*this,column_header);
+            case COLUMN_DOUBLE: return new TypedColumn<double>(*this,column_header);
+            case COLUMN_DICT: return new DictColumn(*this,column_header);
+            case COLUMN_SPARKLINE: return new SparklineColumn(*this,column_header);
+        }
+        if (cell_objects) return new CellColumn(*this,column_header);
+        return new TextColumn(*this,column_header);
+    }
+    virtual void delete_column(Column *c) { delete c; }
+    std::vector<Column*> columns; // by DC
+    bool owns(const Column *c) const { return &c->table==this; } // false => lent by a TableModel
+
+    // painting, done by StringTable: columns and headers draw through the table showing them
+    int font_serial=0;                  // the cell font, cached text widths are for one font
+    Fl_Color sparkline_color=FL_BLUE;   // COLUMN_SPARKLINE lines
+    virtual void draw_text(const char *text,Fl_Align align,int R,int C,int X,int Y,int W,int H) { }
+    virtual void draw_header(const char *label,Fl_Align align,int X,int Y,int W,int H) { }
+    virtual int measure_text(const char *text) { return -1; } // width for the fast path, -1 => needs fl_draw() layout
+    virtual Fl_Color cell_background(int DR,int DC,int R,int C) { return FL_WHITE; }
+    virtual Fl_Color grid_color() { return FL_BLACK; }
+
+    // told about every change of the rows and columns: StringTable keeps its views and damage in step,
+    // TableModel passes them on to the tables showing it
+    virtual bool external_rows() { return false; }          // true => rows come from a DataSource, nothing is stored
+    virtual bool wants_direction() { return false; }        // cell_stored() needs the direction
+    virtual void cell_stored(int DR,int DC,int direction) { } // direction: 1 => number went up, -1 => down
+    virtual void row_updated(int DR,int DC) { }             // cells of a row stored, DC<0 => several columns
+    virtual void rows_updated(const std::vector<int> &DRs) { }
+    virtual void row_added(int DR) { }
+    virtual void row_removing(int DR) { }                   // its cells are still there
+    virtual void row_count_changed() { }
+    virtual void rows_cleared() { }
+    virtual void rows_renumbered() { }                      // compact_rows()
+    virtual void rows_rebuilt() { }                         // rows loaded in one go
+    virtual void column_added(int DC) { }
+    virtual void column_removed(int DC) { }                 // the old column is deleted after this
+    virtual void columns_cleared() { }
+    virtual void column_count_changed() { }
+    virtual void column_width(int DC,int width) { }
+    virtual void column_changed(int DC,bool retyped) { }    // new format, retyped => every cell converted into a new column
+    virtual void update_begun() { }                         // begin_update(), nested calls included
+    virtual void update_ended() { }
+
+    Cell *cell(const int DR,const int DC) { return external_rows() ? NULL : columns[DC]->cell(DR); }
     Cell *cell(const std::string &row_name,const std::string &column_name) {
         const int DR=row_headers.get_idx(row_name);
         if (DR>=0) {
             const int DC=column_headers.get_idx(column_name);
-            if (DC>=0) return data[DR][DC];
+            if (DC>=0) return cell(DR,DC);
         }
         return NULL;
     }
+    virtual std::string getText(const int DR,const int DC) { return columns[DC]->text(DR); }
 
-    void damageCell(const int DR,const int DC) { 
-        int R=row_headers.idx2view(DR),C=column_headers.idx2view(DC);
-        if (R>=0 && C>=0) redraw_range(R,R,C,C);
-    }
-    void damageCell(const std::string &row_name,const std::string &column_name) {
-        const int R=row_headers.get_view(row_name);
-        if (R>=0) {
-            const int C=column_headers.get_view(column_name);
-            if (C>=0) damageCell(R,C);
-        }
+    // stores between begin_update() and end_update() are one batch: a table damages them in one go
+    int update_depth=0;
+
+    void begin_update() { 
+        update_depth++; 
+        update_begun();
     }
-    void damageCells(const int R1,const int C1,const int R2,const int C2) {
-        damage_zone(R1,C1,R2,C2,R2,C2);
+    void end_update() {
+        if (update_depth<=0) return;
+        update_depth--;
+        update_ended();
     }
 
-    void setText(const int DR,const int DC,const std::string &new_text) {
-        Cell *c=cell(DR,DC);
-        if (c) {
-            c->text(new_text);
-            damageCell(DR,DC);
+    void store_text(const int DR,const int DC,const std::string &new_text) { // setText() without re-filtering/sorting the row
+        int direction=0;
+        if (wants_direction() && !external_rows()) {
+            double old_value,new_value;
+            if (columns[DC]->number(DR,old_value) && parse_number(new_text.c_str(),new_value))
+                direction= new_value>old_value ? 1 : new_value<old_value ? -1 : 0;
         }
+        if (!external_rows()) columns[DC]->text(DR,new_text); // with a DataSource the application has updated it already
+        cell_stored(DR,DC,direction);
+    }
+    void setText(const int DR,const int DC,const std::string &new_text) {
+        store_text(DR,DC,new_text);
+        row_updated(DR,DC);
+    }
+    // binary stores into typed columns (text columns get the value formatted). set_number() takes the value
+    // in display units (price, seconds since the epoch), set_integer() the stored integer (ticks, nanoseconds)
+    template<class Store> void set_value(const int DR,const int DC,Store store) {
+        if (external_rows()) return;
+        Column &column=*columns[DC];
+        double old_value,new_value;
+        const bool had_number=wants_direction() && column.number(DR,old_value);
+        store(column);
+        const int direction= had_number && column.number(DR,new_value) ? (new_value>old_value ? 1 : new_value<old_value ? -1 : 0) : 0;
+        cell_stored(DR,DC,direction);
+        row_updated(DR,DC);
     }
+    void setNumber(const int DR,const int DC,const double v) { set_value(DR,DC,[DR,v](Column &c){ c.set_number(DR,v); }); }
+    void setInteger(const int DR,const int DC,const int64_t v) { set_value(DR,DC,[DR,v](Column &c){ c.set_integer(DR,v); }); }
+
     void setText(const std::string &row_name,const std::string &column_name,const std::string &new_text) {
         const int DR=row_headers.get_idx(row_name);
         if (DR>=0) {
@@ -177,31 +1360,162 @@ struct StringTable : public Fl_Table {
         }
     }
 
+
+    // bounded lock-free queue of cell updates: any number of threads post(), the FLTK thread drains it.
+    // only the post() that finds no wakeup pending calls Fl::awake(), so a burst costs one wakeup and the
+    // drain keeps just the latest value per cell before applying everything in one update batch. a drain
+    // takes at most capacity updates and wakes itself again for the rest, so producers can't hold the FLTK thread.
+    // needs Fl::lock() to have been called once by the FLTK thread (as for any Fl::awake() use)
+    struct UpdateQueue {
+        struct Update {
+            std::string row,column,value;
+        };
+        struct Slot {
+            std::atomic<size_t> seq;
+            Update update;
+        };
+        TableData &table;
+        const size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<size_t> head,tail;          // next slot to write/read
+        std::atomic<bool> wake_pending;
+        std::atomic<uint64_t> posted,dropped;
+        uint64_t drained=0,applied=0;           // FLTK thread only
+        bool add_missing_rows=false;            // rows not in the table yet are added (named and labelled by key)
+        std::shared_ptr<UpdateQueue*> alive;    // this queue, NULL once deleted. each pending wakeup holds a copy
+
+        std::vector<Update> batch;              // reused by drain()
+        std::unordered_map<std::string,size_t> latest;
+        std::string key;
+
+        UpdateQueue(TableData &table,size_t min_capacity) 
+        : table(table),capacity(round_up(min_capacity)),slots(new Slot[capacity]),head(0),tail(0),wake_pending(false),posted(0),dropped(0),
+          alive(std::make_shared<UpdateQueue*>(this)) { 
+            for (size_t i=0;i<capacity;i++) 
+                slots[i].seq.store(i,std::memory_order_relaxed);
+        }
+        ~UpdateQueue() { *alive=NULL; } // FLTK thread, like drain_cb() => a wakeup still queued finds no queue
+
+        static size_t round_up(size_t n) {
+            size_t c=2;
+            while (c<n) c<<=1;
+            return c;
+        }
+
+        // any thread, false if the queue is full (counted in dropped)
+        bool post(const std::string &row,const std::string &column,const std::string &value) {
+            size_t pos=head.load(std::memory_order_relaxed);
+            Slot *slot;
+            for (;;) {
+                slot=&slots[pos&(capacity-1)];
+                const size_t seq=slot->seq.load(std::memory_order_acquire);
+                const intptr_t diff=(intptr_t)seq-(intptr_t)pos;
+                if (!diff) {
+                    if (head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) break;
+                } else if (diff<0) {
+                    dropped.fetch_add(1,std::memory_order_relaxed);
+                    return false;
+                } else
+                    pos=head.load(std::memory_order_relaxed);
+            }
+            slot->update.row=row;
+            slot->update.column=column;
+            slot->update.value=value;
+            slot->seq.store(pos+1,std::memory_order_release);
+            posted.fetch_add(1,std::memory_order_relaxed);
+            if (!wake_pending.exchange(true)) wake();
+            return true;
+        }
+        void wake() { // wake_pending was just set
+            auto token=new std::shared_ptr<UpdateQueue*>(alive);
+            if (Fl::awake(drain_cb,token)<0) {
+                delete token;
+                wake_pending=false; // FLTK's awake ring is full => the next post() tries again
+            }
+        }
+        bool pop(Update &out) { // FLTK thread
+            const size_t pos=tail.load(std::memory_order_relaxed);
+            Slot &slot=slots[pos&(capacity-1)];
+            if ((intptr_t)slot.seq.load(std::memory_order_acquire)-(intptr_t)(pos+1)<0) return false;
+            std::swap(out,slot.update); // strings keep their buffers for the next post()
+            tail.store(pos+1,std::memory_order_relaxed);
+            slot.seq.store(pos+capacity,std::memory_order_release);
+            return true;
+        }
+
+        void drain() { // FLTK thread
+            wake_pending=false; // before popping => a post() racing with us wakes us again
+            size_t n=0;         // distinct cells in batch[0..n)
+            latest.clear();
+            for (size_t popped=0;;popped++) {
+                if (popped==capacity) { // more later, events and redraws first
+                    if (!wake_pending.exchange(true)) wake();
+                    break;
+                }
+                if (n==batch.size()) batch.emplace_back();
+                Update &u=batch[n];
+                if (!pop(u)) break;
+                drained++;
+                key.assign(u.row); key+='\0'; key+=u.column;
+                auto i=latest.find(key);
+                if (i==latest.end()) 
+                    latest.emplace(key,n++);
+                else
+                    std::swap(batch[i->second].value,u.value); // newer value wins, batch[n] gets reused
+            }
+            if (!n) return;
+            table.begin_update();
+            bool rows_added=false;
+            for (size_t i=0;i<n;i++) {
+                Update &u=batch[i];
+                int DR=table.row_headers.get_idx(u.row);
+                if (DR<0 && add_missing_rows) {
+                    DR=table.add_row(u.row,u.row,false);
+                    rows_added=true;
+                }
+                const int DC=table.column_headers.get_idx(u.column);
+                if (DR>=0 && DC>=0) table.setText(DR,DC,u.value);
+                applied++;
+            }
+            if (rows_added) table.row_count_changed();
+            table.end_update();
+        }
+        static void drain_cb(void *data) {
+            std::unique_ptr<std::shared_ptr<UpdateQueue*> > token((std::shared_ptr<UpdateQueue*>*)data);
+            if (**token) (**token)->drain();
+        }
+
+        size_t depth() const { return head.load()-tail.load(); } // approximate when producers are active
+        double conflation_ratio() const { return applied ? (double)drained/applied : 1.0; } // updates drained per cell update applied
+    };
+    std::unique_ptr<UpdateQueue> updates;
+
+    // create the queue on first use; the table must not be deleted while producers can still post(),
+    // a wakeup still pending when it is deleted does nothing
+    UpdateQueue &update_queue(const size_t capacity=65536) {
+        if (!updates) updates.reset(new UpdateQueue(*this,capacity));
+        return *updates;
+    }
+
     void clear() {
         clear_rows();
+        std::vector<Column*> old;
+        old.swap(columns);
         for (auto h : column_headers.headers) 
             delete_header(h);
-        column_headers.headers.clear();
-        column_headers.name2idx.clear();
-        column_headers.view.clear();
-        column_headers.reverse_view.clear();
-        set_cols();
+        column_headers.clear();
+        columns_cleared();
+        for (auto c : old)
+            if (owns(c)) delete_column(c);
     }
 
     void clear_rows() {
-        set_selection(-1,-1,-1,-1);
-        for (int r=0;r<(int)row_headers.headers.size();r++) {
-            Header &row_header=*row_headers.headers[r];
-            for (int c=0;c<(int)column_headers.headers.size();c++)
-                delete_cell(cell(r,c));
-            delete_header(&row_header);
-        }
-        data.clear();
-        row_headers.headers.clear();
-        row_headers.name2idx.clear();
-        row_headers.view.clear();
-        row_headers.reverse_view.clear();
-        set_rows();
+        for (auto c : columns)
+            if (owns(c)) c->resize(0);
+        for (auto h : row_headers.headers)
+            if (h) delete_header(h);
+        row_headers.clear();
+        rows_cleared();
     }
     
     int add_column(const std::string &name,const std::string &label,const int width=0,const Fl_Align data_align=FL_ALIGN_CENTER,const bool _set_cols=true) {
@@ -209,106 +1523,1719 @@ struct StringTable : public Fl_Table {
         if (DC>=0) 
             column_headers.headers[DC]->set_label(label);
         else {
-            DC=column_headers.headers.size();
             Header *new_header=header_factory(true,name,label);
-            column_headers.headers.push_back(new_header);
-            column_headers.view.push_back(DC);
-            column_headers.reverse_view.push_back(column_headers.view.size()-1);
-            column_headers.name2idx[name]=DC;
+            DC=column_headers.add(new_header); // columns are never released => always appended
             new_header->column_data_align=data_align;
-            for (int r=0;r<(int)row_headers.headers.size();r++) {
-                data[r].resize(DC+1);
-                data[r][DC]=cell_factory(*row_headers.headers[r],*new_header);
-            }
-        }
-        if (width) {
-            int C=column_headers.idx2view(DC);
-            if (C>=0) col_width(C,width);
+            columns.push_back(column_factory(*new_header));
+            columns.back()->resize(row_headers.headers.size());
+            column_added(DC);
         }
-        if (_set_cols) set_cols();
+        if (width) column_width(DC,width);
+        if (_set_cols) column_count_changed();
         return DC;
     }
-    bool remove_column(const std::string &name,const bool _set_cols=true) {
-        int DC=column_headers.get_idx(name);
-        if (DC<0) return false;
-         
-        column_headers.view_remove(DC);
-        set_selection(-1,-1,-1,-1);
-        for (int r=0;r<(int)row_headers.headers.size();r++) {
-            delete_cell(data[r][DC]);
-            data[r].erase(data[r].begin()+DC);
+    int add_column(const std::string &name,const std::string &label,const ColumnFormat &format,const int width=0,const Fl_Align data_align=FL_ALIGN_RIGHT,const bool _set_cols=true) {
+        const int DC=add_column(name,label,width,data_align,_set_cols);
+        set_column_format(DC,format);
+        return DC;
+    }
+    void set_column_format(const int DC,const ColumnFormat &format) { // existing values are converted through their text
+        Header &header=*column_headers.headers[DC];
+        const ColumnFormat old_format=header.column_format;
+        header.column_format=format;
+        if (format.type==old_format.type && (format.type!=COLUMN_PRICE || format.tick==old_format.tick)) {
+            columns[DC]->format_changed(); // same values, shown differently
+            column_changed(DC,false);
+            return;
         }
-        for (auto &i : column_headers.name2idx) {
-            if (i.second>=DC) --i.second;
+        Column *old=columns[DC],*column=column_factory(header);
+        const int n=row_headers.headers.size();
+        column->resize(n);
+        if (!external_rows()) {
+            std::string tmp;
+            header.column_format=old_format; // the old column still formats with it
+            std::vector<std::string> texts(n);
+            for (int DR=0;DR<n;DR++) 
+                if (row_headers.headers[DR]) texts[DR]=old->text_ptr(DR,tmp);
+            header.column_format=format;
+            for (int DR=0;DR<n;DR++) 
+                if (row_headers.headers[DR]) column->text(DR,texts[DR]);
         }
+        columns[DC]=column;
+        column_changed(DC,true);
+        if (owns(old)) delete_column(old);
+    }
+    void compact_rows() { // renumber rows to drop the slots of removed ones, changes the DR of rows
+        const std::vector<int> old_slot=row_headers.compact();
+        for (auto c : columns) {
+            c->remap(old_slot);
+            c->remap_proxies(old_slot);
+        }
+        rows_renumbered();
+    }
+    bool remove_column(const std::string &name,const bool _set_cols=true) {
+        int DC=column_headers.get_idx(name);
+        if (DC<0) return false;
+         
+        Column *old=columns[DC];
+        columns.erase(columns.begin()+DC);
+        delete_header(column_headers.erase(DC));
+        column_removed(DC);
+        if (owns(old)) delete_column(old);
 
-        Header *h=column_headers.headers[DC];
-        column_headers.headers.erase(column_headers.headers.begin()+DC);
-        delete_header(h);
-
-        if (_set_cols) set_cols();
+        if (_set_cols) column_count_changed();
         return true;
     }
     
     int add_row(const std::string &name,const std::string &label,const bool _set_rows=true) {
+        if (external_rows()) return -1;
         int DR=row_headers.get_idx(name);
         if (DR>=0) 
             row_headers.headers[DR]->set_label(label);
         else {
-            DR=row_headers.headers.size();
             Header *new_header=header_factory(false,name,label);
-            row_headers.headers.push_back(new_header);
-            row_headers.view.push_back(DR);
-            row_headers.reverse_view.push_back(row_headers.view.size()-1);
-            row_headers.name2idx[name]=DR;
-            data.resize(DR+1);
-            data[DR].resize(column_headers.headers.size());
-            for (int c=0;c<(int)column_headers.headers.size();c++)
-                data[DR][c]=cell_factory(*new_header,*column_headers.headers[c]);
-        }
-        if (_set_rows) set_rows();
+            const bool reused=!row_headers.free_slots.empty();
+            DR=row_headers.add(new_header);
+            for (auto c : columns) {
+                if (reused) c->init_slot(DR);
+                else c->resize(DR+1);
+            }
+            row_added(DR);
+        }
+        if (_set_rows) row_count_changed();
         return DR;
     }
     bool remove_row(const std::string &name,const bool _set_rows=true) {
         int DR=row_headers.get_idx(name);
         if (DR<0) return false;
 
-        row_headers.view_remove(DR);
+        row_removing(DR);
+        for (auto c : columns)
+            c->clear_slot(DR);
+        delete_header(row_headers.release(DR));
+        if (row_headers.compact_due()) compact_rows();
+
+        if (_set_rows) row_count_changed();
+        return true;
+    }
+
+    // rows keyed by several fields (symbol,account,side...): the parts are joined into the row name in a
+    // reused buffer, so finding the row is one hash lookup in row_headers without allocating
+    static const char key_separator='\x1f';
+    std::string key_buffer;
+    typedef std::vector<std::pair<int,std::string> > CellValues; // (DC,text)
+
+    const std::string &row_key(const std::vector<std::string> &key) { // valid until the next call
+        key_buffer.clear();
+        for (size_t i=0;i<key.size();i++) {
+            if (i) key_buffer+=key_separator;
+            key_buffer+=key[i];
+        }
+        return key_buffer;
+    }
+    int find_row(const std::vector<std::string> &key) { return row_headers.get_idx(row_key(key)); }
+    int upsert(const std::vector<std::string> &key,const CellValues &values) { // add the row if missing, set its cells in one damage batch
+        if (external_rows()) return -1;
+        begin_update();
+        int DR=row_headers.get_idx(row_key(key));
+        const bool added=DR<0;
+        if (added) {
+            std::string label;
+            for (auto &part : key) {
+                if (!label.empty()) label+=' ';
+                label+=part;
+            }
+            DR=add_row(key_buffer,label,false);
+            row_count_changed();
+        }
+        for (auto &v : values) 
+            store_text(DR,v.first,v.second);
+        row_updated(DR,values.size()==1 ? values[0].first : -1);
+        end_update();
+        return DR;
+    }
+    struct Upsert {
+        std::vector<std::string> key;
+        CellValues values;
+    };
+    void upsert_many(const std::vector<Upsert> &batch) {
+        if (external_rows()) return;
+        begin_update();
+        const size_t n=row_headers.headers.size()+batch.size(); // at most
+        row_headers.reserve(n);
+        for (auto c : columns) c->reserve(n,0);
+        for (auto &u : batch) upsert(u.key,u.values);
+        end_update();
+    }
+
+    // replace the contents with a full snapshot but only touch what differs: rows are matched by name,
+    // cells compared (in parallel for large snapshots) and only changed cells stored and damaged,
+    // missing rows added and rows not in the snapshot removed
+    struct SnapshotRow {
+        std::string name;               // row name, row_key() for composite keys
+        std::vector<std::string> texts; // by DC, cells after the last one are left alone
+    };
+    virtual void apply_snapshot(const std::vector<SnapshotRow> &snapshot) {
+        if (external_rows()) return;
+        const size_t n=snapshot.size();
+        // compare: read only, one writer per row
+        std::vector<int> DRs(n);
+        std::vector<char> changed(n,0);
+        parallel_for(n,[&](size_t b,size_t e){
+            for (size_t i=b;i<e;i++) {
+                const SnapshotRow &row=snapshot[i];
+                const int DR=DRs[i]=row_headers.get_idx(row.name);
+                if (DR<0) continue;
+                const size_t cells=std::min(row.texts.size(),columns.size());
+                for (size_t DC=0;DC<cells && !changed[i];DC++) 
+                    if (!columns[DC]->equals(DR,row.texts[DC])) changed[i]=1;
+            }
+        },std::all_of(columns.begin(),columns.end(),[](Column *c){ return c->concurrent_reads(); }));
+
+        begin_update();
+        std::vector<char> seen(row_headers.slot_count(),0);
+        std::vector<int> touched; // rows to re-filter/re-sort/re-aggregate
+        bool rows_added=false;
+        for (size_t i=0;i<n;i++) {
+            const SnapshotRow &row=snapshot[i];
+            int DR=DRs[i];
+            if (DR>=0) {
+                seen[DR]=1;
+                if (!changed[i]) continue;
+            } else {
+                DR=row_headers.get_idx(row.name); // listed twice
+                if (DR<0) {
+                    DR=add_row(row.name,row.name,false);
+                    rows_added=true;
+                }
+                if (DR>=(int)seen.size()) seen.resize(DR+1,0);
+                seen[DR]=1;
+            }
+            const size_t cells=std::min(row.texts.size(),columns.size());
+            for (size_t DC=0;DC<cells;DC++) 
+                if (!columns[DC]->equals(DR,row.texts[DC])) store_text(DR,DC,row.texts[DC]);
+            touched.push_back(DR);
+        }
+        rows_updated(touched);
+        std::vector<std::string> removed; // by name, removing may renumber the rows
+        for (int DR=0;DR<(int)seen.size();DR++) 
+            if (!seen[DR] && row_headers.headers[DR]) removed.push_back(row_headers.headers[DR]->name);
+        for (auto &name : removed) remove_row(name,false);
+        if (rows_added || !removed.empty()) row_count_changed();
+        end_update();
+    }
+
+    int parallel_min_rows=50000;        // sort/scan in several threads from this many rows
+    int max_threads=0;                  // 0 => std::thread::hardware_concurrency()
+
+    // split [0,n) over the hardware threads and run f(begin,end) on each part
+    template<class F> void parallel_for(const size_t n,F f,const bool parallel=true) { // !parallel => all on this thread
+        size_t threads=max_threads>0 ? max_threads : std::thread::hardware_concurrency();
+        if (n<(size_t)parallel_min_rows || threads<2 || !parallel) { f(0,n); return; }
+        threads=std::min(threads,n/std::max<size_t>(1,parallel_min_rows/4)+1);
+        std::vector<std::thread> workers;
+        const size_t chunk=(n+threads-1)/threads;
+        for (size_t b=chunk;b<n;b+=chunk)
+            workers.emplace_back(f,b,std::min(n,b+chunk));
+        f(0,std::min(n,chunk));
+        for (auto &t : workers) t.join();
+    }
+    // whole file in memory: mapped if it is a regular file, else read (pipes...)
+    struct MappedFile {
+        const char *data=NULL;
+        size_t size=0;
+        void *mapped=MAP_FAILED;
+        std::string buffer;
+
+        ~MappedFile() { if (mapped!=MAP_FAILED) munmap(mapped,size); }
+        std::string open(const int fd) {
+            struct stat st;
+            if (fstat(fd,&st)) return std::string("could not stat file: ")+strerror(errno);
+            size=st.st_size;
+            if (S_ISREG(st.st_mode) && size) mapped=mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+            if (mapped!=MAP_FAILED) {
+                madvise(mapped,size,MADV_SEQUENTIAL);
+                data=(const char*)mapped;
+                return std::string();
+            }
+            char buf[65536];
+            for (ssize_t n;(n=read(fd,buf,sizeof(buf)))!=0;) {
+                if (n<0) {
+                    if (errno==EINTR) continue;
+                    return std::string("could not read file: ")+strerror(errno);
+                }
+                buffer.append(buf,n);
+            }
+            data=buffer.data();
+            size=buffer.size();
+            return std::string();
+        }
+    };
+
+    // CSV/TSV files. import maps the file, finds the line boundaries in parallel and loads everything
+    // in one update batch with a single set_rows()/set_cols(); export (StringTable) streams the current view order
+    struct CsvOptions {
+        char separator;             // '\t' for TSV
+        bool quotes;                // "..." fields, "" inside them is a quote
+        bool header_row;            // first line holds the column names
+        int key_column;             // field (0 based) naming the rows, -1 => line number
+        bool replace;               // clear the rows first, else rows with existing names are updated
+        CsvOptions(char separator=',') : separator(separator),quotes(true),header_row(true),key_column(-1),replace(true) { }
+    };
+
+    static void csv_split(const char *p,const char *end,const CsvOptions &options,std::vector<std::string> &fields,size_t &count) {
+        if (end>p && end[-1]=='\r') end--;
+        count=0;
+        for (;;) {
+            if (count==fields.size()) fields.emplace_back();
+            std::string &f=fields[count++];
+            f.clear();
+            if (options.quotes && p<end && *p=='"') {
+                for (p++;p<end;p++) {
+                    if (*p=='"') {
+                        if (p+1<end && p[1]=='"') p++;
+                        else { p++; break; }
+                    }
+                    f+=*p;
+                }
+                while (p<end && *p!=options.separator) f+=*p++; // junk after the closing quote
+            } else {
+                const char *e=(const char*)memchr(p,options.separator,end-p);
+                if (!e) e=end;
+                f.assign(p,e-p);
+                p=e;
+            }
+            if (p>=end) return;
+            p++; // separator
+        }
+    }
+    // start of every line, a newline inside quotes does not end a line. each thread scans a chunk and keeps
+    // the newlines for both possible quote states at its start, the state is then known from the chunks before it
+    std::vector<size_t> csv_lines(const char *data,const size_t size,const CsvOptions &options) {
+        size_t threads=max_threads>0 ? max_threads : std::thread::hardware_concurrency();
+        if (size<(size_t)parallel_min_rows*64 || threads<2) threads=1;
+        struct Chunk {
+            std::vector<size_t> lines[2]; // newlines (+1) if the chunk starts outside/inside quotes
+            bool odd_quotes=false;
+        };
+        std::vector<Chunk> chunks(threads);
+        const size_t chunk_size=(size+threads-1)/threads;
+        auto scan=[&](size_t n){
+            Chunk &c=chunks[n];
+            const size_t b=n*chunk_size,e=std::min(size,b+chunk_size);
+            bool inside=false;
+            for (size_t i=b;i<e;i++) {
+                const char ch=data[i];
+                if (ch=='\n') c.lines[inside].push_back(i+1);
+                else if (ch=='"' && options.quotes) inside=!inside;
+            }
+            c.odd_quotes=inside;
+        };
+        std::vector<std::thread> workers;
+        for (size_t n=1;n<threads;n++) workers.emplace_back(scan,n);
+        scan(0);
+        for (auto &t : workers) t.join();
+
+        std::vector<size_t> lines;
+        size_t total=1;
+        for (auto &c : chunks) total+=std::max(c.lines[0].size(),c.lines[1].size());
+        lines.reserve(total);
+        lines.push_back(0);
+        bool inside=false;
+        for (auto &c : chunks) {
+            // lines[inside] were recorded with the quote state flipped relative to the real one when inside
+            const std::vector<size_t> &l=c.lines[inside ? 1 : 0];
+            lines.insert(lines.end(),l.begin(),l.end());
+            inside^=c.odd_quotes;
+        }
+        if (lines.back()!=size) lines.push_back(size); // => line i is [lines[i],lines[i+1]-1)
+        else if (lines.size()==1) lines.push_back(0);
+        return lines;
+    }
+
+    std::string import_csv(const std::string &path,const CsvOptions &options=CsvOptions()) {
+        const int fd=open(path.c_str(),O_RDONLY);
+        if (fd<0) return "could not open "+path+": "+strerror(errno);
+        const std::string err=import_csv(fd,options);
+        close(fd);
+        return err;
+    }
+    std::string import_csv(const int fd,const CsvOptions &options=CsvOptions()) {
+        if (external_rows()) return "the rows of a table with a DataSource are not stored in it";
+        MappedFile file;
+        const std::string err=file.open(fd);
+        if (!err.empty()) return err;
+        const char *data=file.data;
+        const size_t size=file.size;
+
+        const std::vector<size_t> lines=csv_lines(data,size,options);
+        std::vector<std::string> fields;
+        size_t count;
+        std::vector<int> field_DC; // field => column
+        size_t first=0;
+
+        begin_update();
+        if (options.replace) clear_rows();
+        if (options.header_row && lines.size()>1) {
+            csv_split(data+lines[0],data+lines[1]-(lines[1]>lines[0] && data[lines[1]-1]=='\n'),options,fields,count);
+            for (size_t f=0;f<count;f++) 
+                field_DC.push_back(add_column(fields[f],fields[f],0,FL_ALIGN_CENTER,false));
+            first=1;
+        }
+        const int new_rows=lines.size()-1-first;
+        row_headers.reserve(row_headers.headers.size()+new_rows);
+        for (auto c : columns) 
+            c->reserve(row_headers.headers.size()+new_rows,size/std::max<size_t>(1,columns.size()));
+        std::string name;
+        for (size_t l=first;l+1<lines.size();l++) {
+            const char *b=data+lines[l],*e=data+lines[l+1];
+            if (e>b && e[-1]=='\n') e--;
+            if (e==b || (e==b+1 && *b=='\r')) continue; // empty line
+            csv_split(b,e,options,fields,count);
+            while (field_DC.size()<count) { // more fields than columns
+                const std::string column_name="col"+std::to_string(field_DC.size()+1);
+                field_DC.push_back(add_column(column_name,column_name,0,FL_ALIGN_CENTER,false));
+            }
+            if (options.key_column>=0 && options.key_column<(int)count) name=fields[options.key_column];
+            else name=std::to_string(l+1-first);
+            const int DR=add_row(name,name,false);
+            if (DR<0) break; // DataSource mode
+            for (size_t f=0;f<count;f++) 
+                columns[field_DC[f]]->text(DR,fields[f]);
+        }
+        column_count_changed();
+        rows_rebuilt();
+        end_update();
+        return std::string();
+    }
+    // binary snapshot of the stored table: headers, views, column widths and cells. load_state() maps the
+    // file and copies the cell sections straight into the columns, so a restart shows the last state at once.
+    // free row slots are dropped => rows get new DRs
+    static const uint32_t state_version=2; // 2: column history
+    struct StateView { // what a table shows of the rows and columns, in which order and size
+        std::vector<int32_t> column_view,widths,row_view; // row_view in file DRs
+        int32_t header_width=0,row_height=0;    // 0 => not known
+    };
+    virtual void save_view(StateView &v,const std::vector<int> &new_DR) {
+        for (int C=0;C<column_headers.size();C++) {
+            v.column_view.push_back(column_headers.view2idx(C));
+            v.widths.push_back(0);
+        }
+        if (row_headers.indexed) {
+            for (auto DR : row_headers.view.to_vector()) v.row_view.push_back(new_DR[DR]);
+        } else {
+            for (auto DR : new_DR) 
+                if (DR>=0) v.row_view.push_back(DR);
+        }
+    }
+    virtual void load_view(const StateView &v) {
+        column_headers.set_view(std::vector<int>(v.column_view.begin(),v.column_view.end()));
+        if (row_headers.indexed) row_headers.set_view(std::vector<int>(v.row_view.begin(),v.row_view.end()));
+    }
+    std::string save_state(const std::string &path) {
+        if (external_rows()) return "the rows of a table with a DataSource are not stored in it";
+        std::vector<char> buffer(1<<20); // outlives fclose()
+        std::FILE *f=fopen(path.c_str(),"wb");
+        if (!f) return "could not open "+path+": "+strerror(errno);
+        setvbuf(f,buffer.data(),_IOFBF,buffer.size());
+        StateWriter w(f);
+        w.put("FLSTTBL",8);
+        w.put(state_version);
+        w.put((uint32_t)0);
+
+        w.put((uint32_t)columns.size());
+        for (auto h : column_headers.headers) {
+            w.string(h->name);
+            w.string(h->label);
+            w.put((int32_t)h->column_header_align);
+            w.put((int32_t)h->column_data_align);
+            w.put((int32_t)h->column_format.type);
+            w.put((int32_t)h->column_format.precision);
+            w.put(h->column_format.tick);
+            w.string(h->column_format.format);
+            w.put((int32_t)h->column_format.history);
+        }
+        std::vector<int> DRs,new_DR(row_headers.slot_count(),-1); // live rows
+        for (int DR=0;DR<row_headers.slot_count();DR++) {
+            if (!row_headers.headers[DR]) continue;
+            new_DR[DR]=DRs.size();
+            DRs.push_back(DR);
+        }
+        w.put((uint32_t)DRs.size());
+        for (auto DR : DRs) {
+            w.string(row_headers.headers[DR]->name);
+            w.string(row_headers.headers[DR]->label);
+        }
+        w.align();
+
+        StateView v;
+        save_view(v,new_DR);
+        w.array(v.column_view);
+        w.array(v.widths);
+        w.array(v.row_view);
+        w.put(v.header_width);
+        w.put(v.row_height);
+
+        for (auto c : columns) c->save_cells(w,DRs);
+
+        const bool failed=fflush(f)!=0 || ferror(f);
+        if (fclose(f) || failed) return "could not write "+path+": "+strerror(errno);
+        return std::string();
+    }
+    std::string load_state(const std::string &path) { // replaces columns, rows, views and widths
+        const int fd=open(path.c_str(),O_RDONLY);
+        if (fd<0) return "could not open "+path+": "+strerror(errno);
+        MappedFile file;
+        std::string err=file.open(fd);
+        close(fd);
+        if (!err.empty()) return err;
+        StateReader r(file.data,file.size);
+        const char *magic=r.get(8);
+        if (!magic || memcmp(magic,"FLSTTBL",8)) return path+" is not a table state file";
+        const uint32_t version=r.get<uint32_t>();
+        r.get<uint32_t>();
+        if (version<1 || version>state_version) return path+": unsupported table state version "+std::to_string(version);
+
+        begin_update();
+        clear();
+        err=read_state(r,version);
+        if (!err.empty()) {
+            clear();
+            err=path+": "+err;
+        } else {
+            column_count_changed();
+            rows_rebuilt();
+        }
+        end_update();
+        return err;
+    }
+    std::string read_state(StateReader &r,const uint32_t version) {
+        const uint32_t ncols=r.get<uint32_t>();
+        for (uint32_t DC=0;DC<ncols && r.ok;DC++) {
+            const std::string name=r.string(),label=r.string();
+            Header *h=header_factory(true,name,label);
+            h->column_header_align=(Fl_Align)r.get<int32_t>();
+            h->column_data_align=(Fl_Align)r.get<int32_t>();
+            h->column_format.type=r.get<int32_t>();
+            h->column_format.precision=r.get<int32_t>();
+            h->column_format.tick=r.get<double>();
+            h->column_format.format=r.string();
+            if (version>=2) h->column_format.history=r.get<int32_t>();
+            if (column_headers.get_idx(name)>=0) { delete_header(h); return "duplicate column "+name; }
+            column_headers.add(h,false);
+            columns.push_back(column_factory(*h));
+        }
+        const uint32_t nrows=r.get<uint32_t>();
+        if (!r.ok || nrows>(r.end-r.p)/8) return "corrupt header section"; // every row needs at least its two lengths
+        row_headers.reserve(nrows);
+        for (uint32_t DR=0;DR<nrows && r.ok;DR++) {
+            const std::string name=r.string(),label=r.string();
+            if (row_headers.get_idx(name)>=0) return "duplicate row "+name;
+            row_headers.add(header_factory(false,name,label),false); // view set below in one go
+        }
+        r.align();
+
+        StateView v;
+        const uint64_t ncolumn_view=r.peek<uint64_t>(); // views may not show everything
+        if (!r.array(v.column_view,ncolumn_view) || !r.array(v.widths,ncolumn_view)) return "corrupt view section";
+        const uint64_t nrow_view=r.peek<uint64_t>();
+        if (!r.array(v.row_view,nrow_view)) return "corrupt view section";
+        v.header_width=r.get<int32_t>();
+        v.row_height=r.get<int32_t>();
+        if (!r.ok || ncolumn_view>ncols || nrow_view>nrows) return "corrupt view section";
+        std::vector<char> seen(std::max(ncols,nrows),0);
+        for (auto DC : v.column_view) {
+            if (DC<0 || DC>=(int)ncols || seen[DC]) return "corrupt column view";
+            seen[DC]=1;
+        }
+        std::fill(seen.begin(),seen.end(),0);
+        for (auto DR : v.row_view) {
+            if (DR<0 || DR>=(int)nrows || seen[DR]) return "corrupt row view";
+            seen[DR]=1;
+        }
+
+        for (uint32_t DC=0;DC<ncols;DC++) {
+            columns[DC]->resize(nrows);
+            if (!columns[DC]->load_cells(r,nrows) || !r.ok) return "cells of column "+column_headers.headers[DC]->name+" do not match its type";
+        }
+
+        load_view(v);
+        return std::string();
+    }
+
+    virtual ~TableData() { }
+};
+
+struct StringTable : public Fl_Table,public TableData {
+
+   virtual void draw_header(const char *label,Fl_Align align,int X,int Y,int W,int H) override {
+       fl_push_clip(X,Y,W,H);
+       fl_draw_box(FL_THIN_UP_BOX,X,Y,W,H,row_header_color());
+       fl_color(FL_BLACK);
+       fl_draw(label,X,Y,W,H,align);
+       fl_pop_clip();
+   }
+
+   void set_column_view(const std::vector<int> &new_view) {
+       column_headers.set_view(new_view);
+       set_cols();
+   }
+   void set_row_view(const std::vector<int> &new_view) {
+       row_headers.set_view(new_view);
+       aggregates_stale=true;
+       set_rows();
+   }
+
+   void set_cols() { cols(column_headers.size()); }
+   void set_rows() {
+       int old=rows();
+       rows(row_headers.size()+(footer ? 1 : 0)); // empty last row => the last data row can scroll above the footer
+       if (!old) row_height_all(default_row_height);
+   }
+
+    virtual void draw_text(const char *text,Fl_Align align,int R,int C,int X,int Y,int W,int H) override {
+        const int DR=frame_DR(R),DC=frame_DC(C);
+        fl_push_clip(X,Y,W,H);
+        fl_color(cell_background(DR,DC,R,C)); fl_rectf(X,Y,W,H); 
+        fl_color(FL_GRAY0); fl_draw(text,X,Y,W,H,align);
+        fl_color(color()); fl_rect(X,Y,W,H);
+        fl_pop_clip();
+    }
+
+    // state computed once per redraw (CONTEXT_STARTPAGE) instead of once per cell
+    struct Frame {
+        int sel_R1=-1,sel_C1=-1,sel_R2=-1,sel_C2=-1;
+        int R=-1,DR=-1;                 // last row looked up
+        std::vector<int> DC;            // by screen column, -2 => not looked up yet
+        Fl_Font font=-1;
+        int size=-1;
+        int height=0,descent=0;
+    } frame;
+
+    void begin_frame() {
+        get_selection(frame.sel_R1,frame.sel_C1,frame.sel_R2,frame.sel_C2);
+        frame.R=-1;
+        frame.DC.assign(cols(),-2);
+        if (frame.font!=default_textfont || frame.size!=default_textsize) {
+            frame.font=default_textfont;
+            frame.size=default_textsize;
+            font_serial=(frame.font<<16)+frame.size+1; // tables with the same font share the widths cached in lent columns
+        }
+        fl_font(default_textfont,default_textsize);
+        frame.height=fl_height();
+        frame.descent=fl_descent();
+        queued_count=0;
+    }
+    int frame_DR(const int R) { // cells arrive row by row => one view lookup per row
+        if (R!=frame.R) { frame.R=R; frame.DR=row_headers.view2idx(R); }
+        return frame.DR;
+    }
+    int frame_DC(const int C) {
+        if (C<0 || C>=(int)frame.DC.size()) return column_headers.view2idx(C);
+        if (frame.DC[C]==-2) frame.DC[C]=column_headers.view2idx(C);
+        return frame.DC[C];
+    }
+    bool frame_selected(const int R,const int C) const { return R>=frame.sel_R1 && C>=frame.sel_C1 && R<=frame.sel_R2 && C<=frame.sel_C2; }
+    virtual Fl_Color cell_background(int DR,int DC,int R,int C) override { 
+        const Fl_Color base=frame_selected(R,C) ? FL_CYAN : FL_WHITE;
+        return flashes.empty() ? base : flash_background(DR,DC,base);
+    }
+    virtual Fl_Color grid_color() override { return color(); }
+
+    // plain text cells of one row are queued and drawn together: one fill per run of cells with the same
+    // background, text without a clip when its cached width shows it fits, grid lines as runs.
+    // full redraws visit cells row by row, Fl_Table's partial redraws column by column => cells of one
+    // column are batched the same way
+    struct QueuedCell {
+        int X,Y,W,H;
+        Fl_Color bg;
+        Fl_Align align;
+        int width;          // text width, <0 => let fl_draw() lay it out with a clip
+        const char *text;   // NULL => in tmp
+        std::string tmp;
+    };
+    std::vector<QueuedCell> queued;
+    size_t queued_count=0;
+    bool queued_column=false;   // queued cells are one column, top to bottom (else one row, left to right)
+
+    virtual int measure_text(const char *text) override {
+        if (strpbrk(text,"@\n\t")) return -1;
+        const double w=fl_width(text);
+        return w<32767 ? (int)(w+0.999) : -1;
+    }
+    QueuedCell &queue_cell(int DR,int DC,int R,int C,int X,int Y,int W,int H) {
+        if (queued_count) {
+            const QueuedCell &first=queued[0];
+            if (queued_count==1) queued_column= first.Y!=Y && first.X==X;
+            if (queued_column ? first.X!=X : first.Y!=Y) flush_queued(); // next column / row
+        }
+        if (queued_count==queued.size()) queued.emplace_back();
+        QueuedCell &q=queued[queued_count++];
+        q.X=X; q.Y=Y; q.W=W; q.H=H;
+        q.bg=cell_background(DR,DC,R,C);
+        q.align=column_headers.headers[DC]->column_data_align;
+        return q;
+    }
+    void flush_queued() {
+        if (!queued_count) return;
+        const bool column=queued_column;
+        auto adjacent=[column](const QueuedCell &a,const QueuedCell &b){ return column ? b.Y==a.Y+a.H : b.X==a.X+a.W; };
+        for (size_t b=0,e;b<queued_count;b=e) { // backgrounds, one rect per run
+            const QueuedCell &first=queued[b];
+            for (e=b+1;e<queued_count && queued[e].bg==first.bg && adjacent(queued[e-1],queued[e]);e++) ;
+            const QueuedCell &last=queued[e-1];
+            fl_color(first.bg);
+            fl_rectf(first.X,first.Y,last.X+last.W-first.X,last.Y+last.H-first.Y);
+        }
+        fl_font(default_textfont,default_textsize);
+        fl_color(FL_GRAY0);
+        for (size_t i=0;i<queued_count;i++) {
+            const QueuedCell &q=queued[i];
+            const char *text=q.text ? q.text : q.tmp.c_str();
+            if (!*text) continue;
+            if (q.width>=0 && q.width<=q.W && frame.height<=q.H) {
+                int x=q.X;
+                if (q.align&FL_ALIGN_RIGHT) x+=q.W-q.width;
+                else if (!(q.align&FL_ALIGN_LEFT)) x+=(q.W-q.width)/2;
+                int y=q.Y+q.H-frame.descent;
+                if (q.align&FL_ALIGN_TOP) y=q.Y+frame.height-frame.descent;
+                else if (!(q.align&FL_ALIGN_BOTTOM)) y=q.Y+(q.H-frame.height)/2+frame.height-frame.descent;
+                fl_draw(text,x,y);
+            } else {
+                fl_push_clip(q.X,q.Y,q.W,q.H);
+                fl_draw(text,q.X,q.Y,q.W,q.H,q.align);
+                fl_pop_clip();
+            }
+        }
+        fl_color(color()); // same pixels as fl_rect() per cell
+        for (size_t b=0,e;b<queued_count;b=e) {
+            const QueuedCell &first=queued[b];
+            for (e=b+1;e<queued_count && adjacent(queued[e-1],queued[e]);e++) ;
+            const QueuedCell &last=queued[e-1];
+            if (column) {
+                fl_yxline(first.X,first.Y,last.Y+last.H-1);
+                fl_yxline(first.X+first.W-1,first.Y,last.Y+last.H-1);
+                for (size_t i=b;i<e;i++) {
+                    fl_xyline(first.X,queued[i].Y,first.X+first.W-1);
+                    fl_xyline(first.X,queued[i].Y+queued[i].H-1,first.X+first.W-1);
+                }
+            } else {
+                fl_xyline(first.X,first.Y,last.X+last.W-1);
+                fl_xyline(first.X,first.Y+first.H-1,last.X+last.W-1);
+                for (size_t i=b;i<e;i++) {
+                    fl_yxline(queued[i].X,first.Y,first.Y+first.H-1);
+                    fl_yxline(queued[i].X+queued[i].W-1,first.Y,first.Y+first.H-1);
+                }
+            }
+        }
+        queued_count=0;
+    }
+
+    // rows supplied by the application instead of add_row()/setText(): nothing is stored per row,
+    // visible cells are asked for when they are drawn. columns are still added with add_column()
+    struct DataSource {
+        virtual ~DataSource() { }
+
+        virtual int row_count()=0;
+        virtual std::string text(int DR,int DC)=0;
+        virtual std::string row_header_text(int DR) { return std::to_string(DR+1); }
+        virtual std::string column_header_text(int DC) { return std::string(); } // empty => column label
+        virtual bool row_exists(int DR) { return true; } // false => DR is an unused slot below row_count()
+        virtual const char *text_ptr(int DR,int DC,std::string &tmp) { tmp=text(DR,DC); return tmp.c_str(); } // valid until the data changes
+        virtual bool number(int DR,int DC,double &out) { return parse_number(text(DR,DC).c_str(),out); }
+        virtual int compare(int DR1,int DR2,int DC) { return text(DR1,DC).compare(text(DR2,DC)); }
+        virtual void detached(StringTable &table) { } // table no longer uses this source
+    };
+    DataSource *source=nullptr;
+    virtual bool external_rows() override { return source!=nullptr; }
+    virtual std::string getText(const int DR,const int DC) override { return source ? source->text(DR,DC) : columns[DC]->text(DR); }
+
+    void set_source(DataSource *new_source) { // NULL => back to rows stored in the table
+        clear_rows();
+        source=new_source;
+        if (source) {
+            row_headers.source_size=source->row_count();
+            row_headers.clear_view(); // use set_row_view() to sort/filter source rows
+            set_rows();
+        }
+        redraw();
+    }
+    void source_changed() { // row_count() changed or many rows were updated
+        if (!source) return;
+        row_headers.source_size=source->row_count();
+        aggregates_stale=true;
+        if (row_headers.indexed) {
+            for (int DR=row_headers.source_size;DR<(int)row_headers.view.nodes.size();DR++)
+                row_headers.view.erase(DR);
+        }
+        set_rows();
+        redraw();
+    }
+    // finer grained than source_changed(): only the affected cells are damaged and rows re-filtered/re-sorted
+    void source_cell_changed(const int DR,const int DC,const int direction=0) { // direction: 1 => number went up, -1 => down
+        cell_stored(DR,DC,direction);
+        row_updated(DR,DC);
+    }
+    void source_row_added(const int DR) {
+        row_headers.source_size=source->row_count();
+        if (row_headers.indexed && !row_headers.view.contains(DR)) {
+            prepare_filters();
+            if (filters.empty() || row_accepted(DR)) {
+                const int R= sort_keys.empty() ? row_headers.view.size() : row_headers.view.lower_bound([this,DR](int other){ return row_less(other,DR); });
+                row_headers.view.insert(R,DR);
+                damageRows(R,INT_MAX/2);
+            }
+        }
+        view_rows_changed();
+        if (!aggregates.empty()) aggregate_row(DR);
+    }
+    void source_row_removed(const int DR) {
+        if (!aggregates.empty()) aggregate_remove(DR);
+        clear_flashes(DR);
+        if (row_headers.indexed && row_headers.view.contains(DR)) {
+            const int R=row_headers.view.position(DR);
+            row_headers.view.erase(DR);
+            damageRows(R,INT_MAX/2);
+        }
+        view_rows_changed();
+    }
+    void source_rows_rebuilt() { // rows renumbered or reloaded => index the existing rows again
+        row_headers.source_size=source->row_count();
+        clear_flashes();
+        set_selection(-1,-1,-1,-1);
+        std::vector<int> rows;
+        for (int DR=0;DR<row_headers.source_size;DR++) 
+            if (source->row_exists(DR)) rows.push_back(DR);
+        row_headers.set_view(rows);
+        structure_changed();
+        if (!filters.empty()) apply_filters(); // sorts too
+        else if (!sort_keys.empty()) sort_rows();
+        set_rows();
+        redraw();
+    }
+
+    // batched updates: between begin_update() and end_update() damageCell()/setText() only set a bit
+    // per cell, end_update() then damages all visible dirty cells at once, at most max_redraw_hz times a second
+    int max_redraw_hz=0;                // 0 => no cap
+    std::vector<uint64_t> dirty_bits;   // dirty_words bits per data row, bit DC
+    int dirty_words=0;
+    std::vector<int> dirty_rows;        // DRs with any bit set
+    bool dirty_all=false;               // rows/columns moved during the batch => redraw everything
+    int moved_R1=INT_MAX,moved_R2=-1;   // screen rows that changed position during the batch
+    bool rows_changed=false;            // rows shown/hidden during the batch => set_rows()
+    bool flush_scheduled=false;
+    std::chrono::steady_clock::time_point last_flush;
+
+    void mark_dirty(const int DR,const int DC) {
+        if (dirty_all) return;
+        if (dirty_rows.empty()) dirty_words=((int)column_headers.headers.size()+63)/64; // bitmap is all clear => relayout
+        if (DC>=dirty_words*64) { // more columns than the bitmap was laid out for
+            dirty_all=true;
+            return;
+        }
+        if ((int)dirty_bits.size()<(DR+1)*dirty_words) dirty_bits.resize((DR+1)*dirty_words*3/2+dirty_words,0);
+        uint64_t &word=dirty_bits[DR*dirty_words+DC/64];
+        const uint64_t bit=(uint64_t)1<<(DC%64);
+        if (word&bit) return;
+        for (int w=0;w<dirty_words;w++) { // first dirty cell in this row
+            if (dirty_bits[DR*dirty_words+w]) { word|=bit; return; }
+        }
+        word|=bit;
+        dirty_rows.push_back(DR);
+    }
+    void clear_dirty() {
+        for (auto DR : dirty_rows) 
+            std::fill(dirty_bits.begin()+DR*dirty_words,dirty_bits.begin()+(DR+1)*dirty_words,0);
+        dirty_rows.clear();
+        dirty_all=false;
+    }
+    void structure_changed() { // data idx of dirty cells no longer valid
+        if (update_depth || flush_scheduled) dirty_all=true;
+        aggregates_stale=true;
+    }
+    void view_rows_changed() { // rows were shown/hidden
+        if (update_depth || flush_scheduled) rows_changed=true;
+        else set_rows();
+    }
+    void flush_damage() {
+        if (footer_dirty) {
+            footer_dirty=false;
+            damage(FL_DAMAGE_USER1);
+        }
+        if (rows_changed) {
+            rows_changed=false;
+            set_rows(); // redraws everything
+            dirty_all=true;
+        }
+        if (dirty_all) 
+            redraw();
+        else if (!dirty_rows.empty() || moved_R2>=0) {
+            // Fl_Table keeps a single damaged range anyway => one range covering the dirty cells on screen
+            int R1=INT_MAX,C1=INT_MAX,R2=-1,C2=-1;
+            if (moved_R2>=0 && moved_R1<=botrow && moved_R2>=toprow) {
+                R1=std::max(moved_R1,toprow); R2=std::min(moved_R2,botrow);
+                C1=leftcol; C2=rightcol;
+            }
+            for (auto DR : dirty_rows) {
+                const int R=row_headers.idx2view(DR);
+                if (R<toprow || R>botrow) continue;
+                for (int w=0;w<dirty_words;w++) {
+                    for (uint64_t bits=dirty_bits[DR*dirty_words+w];bits;bits&=bits-1) {
+                        const int DC=w*64+__builtin_ctzll(bits);
+                        const int C=column_headers.idx2view(DC);
+                        if (C<leftcol || C>rightcol) continue;
+                        R1=std::min(R1,R); R2=std::max(R2,R);
+                        C1=std::min(C1,C); C2=std::max(C2,C);
+                    }
+                }
+            }
+            if (R2>=0) redraw_range(R1,R2,C1,C2);
+        }
+        clear_dirty();
+        moved_R1=INT_MAX; moved_R2=-1;
+        last_flush=std::chrono::steady_clock::now();
+    }
+    static void flush_cb(void *data) {
+        StringTable *t=(StringTable*)data;
+        t->flush_scheduled=false;
+        if (!t->update_depth) t->flush_damage();
+    }
+    void schedule_flush() {
+        if (flush_scheduled) return;
+        if (max_redraw_hz>0) {
+            const double since=std::chrono::duration<double>(std::chrono::steady_clock::now()-last_flush).count();
+            if (since<1.0/max_redraw_hz) {
+                flush_scheduled=true;
+                Fl::add_timeout(1.0/max_redraw_hz-since,flush_cb,this);
+                return;
+            }
+        }
+        flush_damage();
+    }
+
+    void damageRows(const int R1,const int R2) { // all columns of screen rows R1..R2
+        if (update_depth || flush_scheduled) {
+            moved_R1=std::min(moved_R1,R1); 
+            moved_R2=std::max(moved_R2,R2);
+            return;
+        }
+        if (R1<=botrow && R2>=toprow) redraw_range(std::max(R1,toprow),std::min(R2,botrow),leftcol,rightcol);
+    }
+    void damageCell(const int DR,const int DC) { 
+        if (update_depth || flush_scheduled) { 
+            mark_dirty(DR,DC); 
+            return; 
+        }
+        int R=row_headers.idx2view(DR),C=column_headers.idx2view(DC);
+        if (R>=0 && C>=0) redraw_range(R,R,C,C);
+    }
+    void damageCell(const std::string &row_name,const std::string &column_name) {
+        const int DR=row_headers.get_idx(row_name);
+        if (DR>=0) {
+            const int DC=column_headers.get_idx(column_name);
+            if (DC>=0) damageCell(DR,DC);
+        }
+    }
+    void damageCells(const int R1,const int C1,const int R2,const int C2) {
+        damage_zone(R1,C1,R2,C2,R2,C2);
+    }
+
+    // tick flash: changed cells light up in flash_up/flash_down (numeric rise/fall, else flash_changed)
+    // and fade back to their normal background over flash_decay seconds. all tables share one timeout
+    // that only runs while something is fading and damages only cells whose colour actually steps
+    double flash_decay=0;               // seconds, 0 => no flashing
+    Fl_Color flash_up=FL_GREEN,flash_down=FL_RED,flash_changed=FL_YELLOW;
+    static const int flash_steps=16;    // colour levels of the fade
+    struct Flash {
+        double start;
+        Fl_Color color;
+        int step;                       // flash_steps => full flash colour, 0 => faded
+    };
+    std::unordered_map<uint64_t,Flash> flashes; // by DR<<32|DC
+
+    struct FlashTicker {
+        std::vector<StringTable*> tables; // with flashes
+        bool running=false;
+        double interval=1.0/30;
+
+        static FlashTicker &get() { 
+            static FlashTicker ticker; 
+            return ticker; 
+        }
+        static double now() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+        void add(StringTable *t) {
+            if (std::find(tables.begin(),tables.end(),t)==tables.end()) tables.push_back(t);
+            if (!running) {
+                running=true;
+                Fl::add_timeout(interval,tick_cb,this);
+            }
+        }
+        void remove(StringTable *t) { 
+            tables.erase(std::remove(tables.begin(),tables.end(),t),tables.end()); 
+        }
+        static void tick_cb(void *data) {
+            FlashTicker &ticker=*(FlashTicker*)data;
+            const double t=now();
+            for (size_t i=0;i<ticker.tables.size();) {
+                if (ticker.tables[i]->flash_tick(t)) i++;
+                else ticker.tables.erase(ticker.tables.begin()+i); // nothing left to fade
+            }
+            if (ticker.tables.empty()) ticker.running=false;
+            else Fl::repeat_timeout(ticker.interval,tick_cb,data);
+        }
+    };
+
+    static uint64_t cell_key(const int DR,const int DC) { return (uint64_t)(uint32_t)DR<<32|(uint32_t)DC; }
+    void flash_cell(const int DR,const int DC,const Fl_Color color) {
+        if (flash_decay<=0) return;
+        Flash &f=flashes[cell_key(DR,DC)];
+        f.start=FlashTicker::now();
+        f.color=color;
+        f.step=flash_steps;
+        damageCell(DR,DC);
+        FlashTicker::get().add(this);
+    }
+    bool flash_tick(const double now) { // false => no flashes left
+        begin_update();
+        for (auto i=flashes.begin();i!=flashes.end();) {
+            const int DR=i->first>>32,DC=(uint32_t)i->first;
+            const double left=1.0-(now-i->second.start)/flash_decay;
+            const int step= left>0 ? (int)(left*flash_steps+0.999) : 0;
+            if (step!=i->second.step) damageCell(DR,DC);
+            if (step<=0) i=flashes.erase(i);
+            else { i->second.step=step; ++i; }
+        }
+        end_update();
+        return !flashes.empty();
+    }
+    void clear_flashes() {
+        flashes.clear();
+        FlashTicker::get().remove(this);
+    }
+    void clear_flashes(const int DR) { // row removed => a row reusing the slot does not inherit them
+        if (flashes.empty()) return;
+        for (int DC=0;DC<(int)column_headers.headers.size();DC++) 
+            flashes.erase(cell_key(DR,DC));
+    }
+    Fl_Color flash_background(const int DR,const int DC,const Fl_Color base) {
+        auto i=flashes.find(cell_key(DR,DC));
+        if (i==flashes.end()) return base;
+        return fl_color_average(i->second.color,base,(float)i->second.step/flash_steps);
+    }
+
+    Fl_Color flash_color(const int direction) const { return direction>0 ? flash_up : direction<0 ? flash_down : flash_changed; }
+
+    // TableData changes => row view, selection, flashes, totals and damage of this table
+    virtual bool wants_direction() override { return flash_decay>0; }
+    virtual void cell_stored(int DR,int DC,int direction) override {
+        if (flash_decay>0) flash_cell(DR,DC,flash_color(direction));
+        damageCell(DR,DC);
+    }
+    virtual void row_updated(int DR,int DC) override {
+        if (DC<0 ? !filters.empty() : filter_column(DC)) refilter_row(DR);
+        if (DC<0 ? !sort_keys.empty() : sort_column(DC)) resort_row(DR);
+        if (!aggregates.empty()) aggregate_row(DR);
+    }
+    virtual void rows_updated(const std::vector<int> &DRs) override {
+        const bool refilter=!filters.empty(),resort=!sort_keys.empty();
+        if ((refilter || resort) && DRs.size()>(size_t)row_headers.size()/8+16) { // cheaper in one go
+            if (refilter) apply_filters();
+            else sort_rows();
+        } else {
+            for (auto DR : DRs) {
+                if (refilter) refilter_row(DR);
+                if (resort) resort_row(DR);
+            }
+        }
+        if (!aggregates.empty()) 
+            for (auto DR : DRs) aggregate_row(DR);
+    }
+    virtual void row_added(int DR) override {
+        if (!filters.empty()) prepare_filters();
+        if (!filters.empty() && !row_accepted(DR)) row_headers.view_remove(DR);
+        else if (!sort_keys.empty()) resort_row(DR); // appended => to its sorted position
+    }
+    virtual void row_removing(int DR) override {
+        set_selection(-1,-1,-1,-1);
+        if (!aggregates.empty()) aggregate_remove(DR);
+        clear_flashes(DR);
+    }
+    virtual void row_count_changed() override { view_rows_changed(); }
+    virtual void rows_cleared() override {
+        structure_changed();
+        clear_flashes();
+        set_selection(-1,-1,-1,-1);
+        if (source) source->detached(*this);
+        source=nullptr;
+        row_headers.source_size=-1;
+        row_headers.indexed=true;
+        for (size_t DC=0;DC<columns.size();DC++) // columns lent by a TableModel => empty ones of our own
+            if (!owns(columns[DC])) columns[DC]=column_factory(*column_headers.headers[DC]);
+        set_rows();
+    }
+    virtual void rows_renumbered() override {
+        structure_changed();
+        clear_flashes();
+    }
+    virtual void rows_rebuilt() override {
+        if (!filters.empty()) apply_filters(); // sorts too
+        else if (!sort_keys.empty()) sort_rows();
+        set_rows();
+        structure_changed();
+        redraw();
+    }
+    virtual void column_removed(int DC) override {
+        structure_changed();
         set_selection(-1,-1,-1,-1);
-        for (int c=0;c<(int)data[DR].size();c++)
-            delete_cell(data[DR][c]);
-        data.erase(data.begin()+DR);
-        for (auto &i : row_headers.name2idx) {
-            if (i.second>=DR) --i.second;
+        clear_flashes();
+        sort_keys.erase(std::remove_if(sort_keys.begin(),sort_keys.end(),[DC](const SortKey &k){ return k.DC==DC; }),sort_keys.end());
+        for (auto &k : sort_keys) 
+            if (k.DC>DC) k.DC--;
+        const size_t old_filters=filters.size();
+        filters.erase(std::remove_if(filters.begin(),filters.end(),[DC](const Filter &f){ return f.DC==DC; }),filters.end());
+        for (auto &f : filters) 
+            if (f.DC>DC) f.DC--;
+        aggregates.erase(std::remove_if(aggregates.begin(),aggregates.end(),[DC](const Aggregate &a){ return a.DC==DC || a.weight_DC==DC; }),aggregates.end());
+        for (auto &a : aggregates) {
+            if (a.DC>DC) a.DC--;
+            if (a.weight_DC>DC) a.weight_DC--;
+        }
+        if (filters.size()!=old_filters) apply_filters();
+    }
+    virtual void columns_cleared() override {
+        structure_changed();
+        sort_keys.clear();
+        filters.clear();
+        aggregates.clear();
+        set_cols();
+    }
+    virtual void column_count_changed() override { set_cols(); }
+    virtual void column_width(int DC,int width) override {
+        const int C=column_headers.idx2view(DC);
+        if (C>=0) col_width(C,width);
+    }
+    virtual void column_changed(int DC,bool retyped) override {
+        if (retyped) {
+            aggregates_stale=true;
+            if (filter_column(DC)) apply_filters();
+            else if (sort_column(DC)) sort_rows();
+        }
+        redraw();
+    }
+    virtual void update_ended() override { 
+        if (!update_depth) schedule_flush(); 
+    }
+
+    void clear() { TableData::clear(); } // not Fl_Table::clear()
+    virtual void apply_snapshot(const std::vector<SnapshotRow> &snapshot) override { // selection and scroll position follow the rows
+        if (source) return;
+        int R1,C1,R2,C2;
+        get_selection(R1,C1,R2,C2);
+        const int top_DR=row_headers.view2idx(row_position());
+        const std::string top_name= top_DR>=0 ? row_headers.headers[top_DR]->name : std::string();
+        std::string sel_name1,sel_name2;
+        if (R1>=0 && R2>=0) {
+            const int DR1=row_headers.view2idx(R1),DR2=row_headers.view2idx(R2);
+            if (DR1>=0) sel_name1=row_headers.headers[DR1]->name;
+            if (DR2>=0) sel_name2=row_headers.headers[DR2]->name;
+        }
+        TableData::apply_snapshot(snapshot);
+        if (!sel_name1.empty() && !sel_name2.empty()) {
+            const int new_R1=row_headers.idx2view(row_headers.get_idx(sel_name1)),new_R2=row_headers.idx2view(row_headers.get_idx(sel_name2));
+            if (new_R1>=0 && new_R2>=0) set_selection(std::min(new_R1,new_R2),C1,std::max(new_R1,new_R2),C2);
+            else set_selection(-1,-1,-1,-1);
         }
+        if (!top_name.empty()) {
+            const int R=row_headers.idx2view(row_headers.get_idx(top_name));
+            if (R>=0 && R!=row_position()) row_position(R);
+        }
+    }
+
+    // sorting of the row view on one or more columns
+    enum SortType { SORT_NUMERIC=0,SORT_LEXICAL=1,SORT_CUSTOM=2 };
+    struct SortKey {
+        int DC;
+        bool ascending;
+        int type;   // SORT_NUMERIC: numbers by value before other texts, which compare lexically
+        std::function<int(StringTable &table,int DR1,int DR2)> compare; // SORT_CUSTOM, <0 / 0 / >0
+
+        SortKey(int DC,bool ascending=true,int type=SORT_NUMERIC) : DC(DC),ascending(ascending),type(type) { }
+    };
+    std::vector<SortKey> sort_keys;     // most significant first, empty => rows stay in the order they were added
+    bool sort_on_header_click=false;    // clicking a column header cycles ascending/descending/off, shift-click adds a key
+
+    bool sort_column(const int DC) const {
+        for (auto &k : sort_keys) 
+            if (k.DC==DC) return true;
+        return false;
+    }
+    int compare_key(const SortKey &key,const int DR1,const int DR2,const std::vector<double> *numbers=NULL) {
+        int c=0;
+        if (key.type==SORT_CUSTOM) 
+            c=key.compare(*this,DR1,DR2);
+        else if (source) {
+            double n1,n2;
+            const bool is1=key.type==SORT_NUMERIC && source->number(DR1,key.DC,n1),is2=key.type==SORT_NUMERIC && source->number(DR2,key.DC,n2);
+            c= is1 && is2 ? (n1<n2 ? -1 : n1>n2) : is1!=is2 ? (is1 ? -1 : 1) : source->compare(DR1,DR2,key.DC);
+        } else {
+            Column &column=*columns[key.DC];
+            if (column.typed())
+                c=column.compare(DR1,DR2);
+            else if (key.type==SORT_NUMERIC) {
+                double n1,n2;
+                bool is1,is2;
+                if (numbers) { // prefetched, NaN => not a number
+                    n1=(*numbers)[DR1]; n2=(*numbers)[DR2];
+                    is1=n1==n1; is2=n2==n2;
+                } else {
+                    is1=column.number(DR1,n1); 
+                    is2=column.number(DR2,n2);
+                }
+                c= is1 && is2 ? (n1<n2 ? -1 : n1>n2) : is1!=is2 ? (is1 ? -1 : 1) : column.compare(DR1,DR2);
+            } else
+                c=column.compare(DR1,DR2);
+        }
+        return key.ascending ? c : -c;
+    }
+    bool row_less(const int DR1,const int DR2,const std::vector<std::vector<double> > *numbers=NULL) {
+        for (size_t k=0;k<sort_keys.size();k++) {
+            const int c=compare_key(sort_keys[k],DR1,DR2,numbers && !(*numbers)[k].empty() ? &(*numbers)[k] : NULL);
+            if (c) return c<0;
+        }
+        return DR1<DR2; // deterministic order for equal keys
+    }
 
-        Header *h=row_headers.headers[DR];
-        row_headers.headers.erase(row_headers.headers.begin()+DR);
-        delete_header(h);
+    template<class Less> void parallel_sort(std::vector<int> &v,Less less) {
+        size_t threads=max_threads>0 ? max_threads : std::thread::hardware_concurrency();
+        const bool serial=std::any_of(sort_keys.begin(),sort_keys.end(),[this](const SortKey &k){ return k.type==SORT_CUSTOM || !columns[k.DC]->concurrent_reads(); });
+        if (v.size()<(size_t)parallel_min_rows || threads<2 || source || serial) { // custom compares and cells may not be thread safe
+            std::sort(v.begin(),v.end(),less);
+            return;
+        }
+        // sort chunks in parallel, then merge neighbours pairwise, also in parallel
+        std::vector<size_t> bounds;
+        const size_t chunk=(v.size()+threads-1)/threads;
+        for (size_t b=0;b<v.size();b+=chunk) bounds.push_back(b);
+        bounds.push_back(v.size());
+        std::vector<std::thread> workers;
+        for (size_t i=0;i+1<bounds.size();i++)
+            workers.emplace_back([&v,&bounds,&less,i]{ std::sort(v.begin()+bounds[i],v.begin()+bounds[i+1],less); });
+        for (auto &t : workers) t.join();
+        while (bounds.size()>2) {
+            workers.clear();
+            std::vector<size_t> merged;
+            for (size_t i=0;i+1<bounds.size();i+=2) {
+                merged.push_back(bounds[i]);
+                if (i+2<bounds.size())
+                    workers.emplace_back([&v,&bounds,&less,i]{ std::inplace_merge(v.begin()+bounds[i],v.begin()+bounds[i+1],v.begin()+bounds[i+2],less); });
+            }
+            merged.push_back(v.size());
+            for (auto &t : workers) t.join();
+            bounds.swap(merged);
+        }
+    }
+
+    void sort_rows() { // re-sort the whole row view from sort_keys
+        if (sort_keys.empty() || (!row_headers.indexed && !source)) return;
+        std::vector<int> order= row_headers.indexed ? row_headers.view.to_vector() : std::vector<int>();
+        if (!row_headers.indexed) { // source rows without an index => create one
+            order.resize(row_headers.slot_count());
+            for (int i=0;i<(int)order.size();i++) order[i]=i;
+        }
+        // numeric keys: parse every value once instead of in every comparison
+        std::vector<std::vector<double> > numbers(sort_keys.size());
+        if (!source) {
+            for (size_t k=0;k<sort_keys.size();k++) {
+                Column &column=*columns[sort_keys[k].DC];
+                if (sort_keys[k].type!=SORT_CUSTOM) column.prepare_sort();
+                if (sort_keys[k].type!=SORT_NUMERIC || column.typed()) continue;
+                std::vector<double> &n=numbers[k];
+                n.resize(row_headers.slot_count());
+                parallel_for(order.size(),[&](size_t b,size_t e){
+                    for (size_t i=b;i<e;i++) 
+                        if (!column.number(order[i],n[order[i]])) n[order[i]]=NAN;
+                },column.concurrent_reads());
+            }
+        }
+        parallel_sort(order,[this,&numbers](int a,int b){ return row_less(a,b,&numbers); });
+        row_headers.set_view(order);
+        redraw();
+    }
+    void set_sort(const std::vector<SortKey> &keys) {
+        sort_keys=keys;
+        sort_rows();
+    }
+    void toggle_sort(const int DC,const bool add_key=false) { // none => ascending => descending => none
+        auto i=std::find_if(sort_keys.begin(),sort_keys.end(),[DC](const SortKey &k){ return k.DC==DC; });
+        if (i==sort_keys.end()) {
+            if (!add_key) sort_keys.clear();
+            sort_keys.push_back(SortKey(DC));
+        } else if (i->ascending)
+            i->ascending=false;
+        else 
+            sort_keys.erase(i);
+        sort_rows();
+        redraw();
+    }
+    void resort_row(const int DR) { // a sort key of one row changed => move just that row
+        if (!row_headers.indexed) return;
+        ViewIndex &view=row_headers.view;
+        const int R=view.position(DR);
+        if (R<0) return;
+        const int prev=view.at(R-1),next=view.at(R+1);
+        if ((prev<0 || row_less(prev,DR)) && (next<0 || row_less(DR,next))) return; // still in place
+        view.erase(DR);
+        const int new_R=view.lower_bound([this,DR](int other){ return row_less(other,DR); });
+        view.insert(new_R,DR);
+        damageRows(std::min(R,new_R),std::max(R,new_R));
+    }
 
-        if (_set_rows) set_rows();
+    // row filters: the row view only shows rows accepted by every filter, the data is not touched.
+    // rows that start passing go to their sorted position, or to the end if the view is not sorted
+    enum FilterType { FILTER_EQUAL=0,FILTER_RANGE=1,FILTER_SUBSTRING=2,FILTER_CUSTOM=3 };
+    struct Filter {
+        int DC;                 // column tested, -1 => FILTER_CUSTOM looking at the whole row (re-run on any change)
+        int type;
+        std::string text;       // FILTER_EQUAL, FILTER_SUBSTRING
+        double lo=0,hi=0;       // FILTER_RANGE, inclusive, numeric values only
+        std::function<bool(StringTable &table,int DR)> accept; // FILTER_CUSTOM
+        int code=-2;            // FILTER_EQUAL on a COLUMN_DICT column: code of text from prepare_filters(), -2 => compare texts
+
+        Filter(int DC,int type) : DC(DC),type(type) { }
+        static Filter equal(int DC,const std::string &text) { Filter f(DC,FILTER_EQUAL); f.text=text; return f; }
+        static Filter range(int DC,double lo,double hi) { Filter f(DC,FILTER_RANGE); f.lo=lo; f.hi=hi; return f; }
+        static Filter substring(int DC,const std::string &text) { Filter f(DC,FILTER_SUBSTRING); f.text=text; return f; }
+        static Filter custom(const std::function<bool(StringTable&,int)> &accept,int DC=-1) { Filter f(DC,FILTER_CUSTOM); f.accept=accept; return f; }
+    };
+    std::vector<Filter> filters;
+
+    bool filter_column(const int DC) const {
+        for (auto &f : filters) 
+            if (f.DC==DC || f.DC<0) return true;
+        return false;
+    }
+    bool filter_accepts(const Filter &f,const int DR) {
+        if (f.type==FILTER_CUSTOM) return f.accept(*this,DR);
+        std::string tmp;
+        if (f.type==FILTER_RANGE) {
+            double v;
+            const bool is_number= source ? source->number(DR,f.DC,v) : columns[f.DC]->number(DR,v);
+            return is_number && v>=f.lo && v<=f.hi;
+        }
+        if (f.code!=-2 && !source) return columns[f.DC]->code(DR)==f.code;
+        const char *text= source ? source->text_ptr(DR,f.DC,tmp) : columns[f.DC]->text_ptr(DR,tmp);
+        if (f.type==FILTER_EQUAL) return f.text==text;
+        return strstr(text,f.text.c_str())!=NULL;
+    }
+    void prepare_filters() { // before testing rows: a new dictionary text may now have a code
+        for (auto &f : filters) 
+            f.code= f.type==FILTER_EQUAL && !source && f.DC>=0 ? columns[f.DC]->code(f.text) : -2;
+    }
+    bool row_accepted(const int DR) {
+        for (auto &f : filters) 
+            if (!filter_accepts(f,DR)) return false;
         return true;
     }
 
+    void apply_filters() { // re-evaluate all rows
+        prepare_filters();
+        std::vector<int> rows;
+        rows.reserve(row_headers.slot_count());
+        for (int DR=0;DR<row_headers.slot_count();DR++) 
+            if (source ? source->row_exists(DR) : row_headers.headers[DR]!=NULL) rows.push_back(DR);
+        std::vector<char> pass(row_headers.slot_count(),0);
+        const bool serial=source || std::any_of(filters.begin(),filters.end(),[this](const Filter &f){ // custom filters and cells may not be thread safe
+            return f.type==FILTER_CUSTOM || !columns[f.DC]->concurrent_reads(); 
+        });
+        parallel_for(rows.size(),[&](size_t b,size_t e){
+            for (size_t i=b;i<e;i++) pass[rows[i]]=row_accepted(rows[i]);
+        },!serial);
+
+        std::vector<int> order;
+        if (row_headers.indexed) // keep the order of rows already shown
+            for (auto DR : row_headers.view.to_vector()) 
+                if (pass[DR]) { order.push_back(DR); pass[DR]=0; }
+        for (auto DR : rows) 
+            if (pass[DR]) order.push_back(DR);
+        row_headers.set_view(order);
+        aggregates_stale=true;
+        set_selection(-1,-1,-1,-1);
+        if (!sort_keys.empty()) sort_rows();
+        set_rows();
+        redraw();
+    }
+    void add_filter(const Filter &f) {
+        filters.push_back(f);
+        apply_filters();
+    }
+    void set_filters(const std::vector<Filter> &new_filters) {
+        filters=new_filters;
+        apply_filters();
+    }
+    void clear_filters() {
+        filters.clear();
+        apply_filters();
+    }
+    void refilter_row(const int DR) { // a filtered value of one row changed
+        if (!row_headers.indexed) return;
+        ViewIndex &view=row_headers.view;
+        prepare_filters();
+        const bool shown=view.contains(DR),accepted=row_accepted(DR);
+        if (shown==accepted) return;
+        if (shown) {
+            const int R=view.position(DR);
+            view.erase(DR);
+            damageRows(R,INT_MAX/2);
+        } else {
+            const int R= sort_keys.empty() ? view.size() : view.lower_bound([this,DR](int other){ return row_less(other,DR); });
+            view.insert(R,DR);
+            damageRows(R,INT_MAX/2);
+        }
+        view_rows_changed();
+    }
+
+    // per column totals over the rows in the row view, kept up to date by every cell store instead of
+    // being recomputed: O(1) per change, O(log n) for min/max. row view changes (filters, set_row_view(),
+    // removed columns...) only mark them stale, they are recomputed once when next read or drawn
+    enum AggregateType { AGGREGATE_SUM=0,AGGREGATE_COUNT=1,AGGREGATE_MIN=2,AGGREGATE_MAX=3,AGGREGATE_MEAN=4,AGGREGATE_WEIGHTED_MEAN=5 };
+    struct Aggregate {
+        int DC;
+        int type;
+        int weight_DC;                  // AGGREGATE_WEIGHTED_MEAN: sum(value*weight)/sum(weight), e.g. VWAP from price and quantity
+        long double sum=0,weight_sum=0; // AGGREGATE_WEIGHTED_MEAN: sum is of value*weight
+        int64_t count=0;                // values included
+        std::multiset<double> values;   // AGGREGATE_MIN/MAX
+        std::vector<double> value,weight; // included per DR, NAN => none
+
+        Aggregate(int DC,int type,int weight_DC=-1) : DC(DC),type(type),weight_DC(weight_DC) { }
+
+        void reset() {
+            sum=weight_sum=0;
+            count=0;
+            values.clear();
+            value.clear();
+            weight.clear();
+        }
+        bool set(const int DR,const double v,const double w) { // false => unchanged
+            if (DR>=(int)value.size()) {
+                if (v!=v) return false;
+                value.resize(DR+1,NAN);
+                weight.resize(DR+1,NAN);
+            }
+            double &old=value[DR],&old_w=weight[DR];
+            if (old!=old && v!=v) return false;
+            if (old==v && old_w==w) return false;
+            if (old==old) {
+                count--;
+                if (type==AGGREGATE_WEIGHTED_MEAN) { sum-=(long double)old*old_w; weight_sum-=old_w; }
+                else sum-=old;
+                if (type==AGGREGATE_MIN || type==AGGREGATE_MAX) values.erase(values.find(old));
+            }
+            old=v; old_w=w;
+            if (v==v) {
+                count++;
+                if (type==AGGREGATE_WEIGHTED_MEAN) { sum+=(long double)v*w; weight_sum+=w; }
+                else sum+=v;
+                if (type==AGGREGATE_MIN || type==AGGREGATE_MAX) values.insert(v);
+            }
+            if (!count) sum=weight_sum=0; // no drift left behind once empty
+            return true;
+        }
+        bool result(double &out) const { // false => no values
+            switch (type) {
+                case AGGREGATE_SUM: out=sum; return count>0;
+                case AGGREGATE_COUNT: out=count; return true;
+                case AGGREGATE_MIN: if (values.empty()) return false; out=*values.begin(); return true;
+                case AGGREGATE_MAX: if (values.empty()) return false; out=*values.rbegin(); return true;
+                case AGGREGATE_MEAN: if (!count) return false; out=sum/count; return true;
+                case AGGREGATE_WEIGHTED_MEAN: if (weight_sum==0) return false; out=sum/weight_sum; return true;
+            }
+            return false;
+        }
+    };
+    std::vector<Aggregate> aggregates;
+    bool aggregates_stale=false;
+    bool footer=false;                  // use show_footer()
+    bool footer_dirty=false;            // footer changed during an update batch
+    std::string footer_label="Total";
+
+    bool cell_number(const int DR,const int DC,double &out) {
+        return source ? source->number(DR,DC,out) : columns[DC]->number(DR,out);
+    }
+    bool row_shown(const int DR) const {
+        if (row_headers.indexed) return row_headers.view.contains(DR);
+        return source ? DR<row_headers.source_size && source->row_exists(DR) : row_headers.headers[DR]!=NULL;
+    }
+    bool aggregate_row(const int DR) { // re-read one row, true => a total changed
+        if (aggregates_stale) { footer_changed(); return true; }
+        const bool shown=row_shown(DR);
+        bool changed=false;
+        for (auto &a : aggregates) {
+            double v=NAN,w=1;
+            if (!shown || !cell_number(DR,a.DC,v) || (a.weight_DC>=0 && !cell_number(DR,a.weight_DC,w))) v=NAN;
+            if (a.set(DR,v,w)) changed=true;
+        }
+        if (changed) footer_changed();
+        return changed;
+    }
+    void aggregate_remove(const int DR) {
+        if (aggregates_stale) return;
+        bool changed=false;
+        for (auto &a : aggregates) 
+            if (a.set(DR,NAN,NAN)) changed=true;
+        if (changed) footer_changed();
+    }
+    void update_aggregates() { // full recompute if stale
+        if (!aggregates_stale) return;
+        aggregates_stale=false;
+        for (auto &a : aggregates) a.reset();
+        if (aggregates.empty()) return;
+        if (row_headers.indexed) {
+            for (auto DR : row_headers.view.to_vector()) aggregate_row(DR);
+        } else {
+            for (int DR=0;DR<row_headers.slot_count();DR++) 
+                if (row_shown(DR)) aggregate_row(DR);
+        }
+    }
+    int add_aggregate(const int DC,const int type,const int weight_DC=-1) { // returns its index for aggregate()
+        aggregates.push_back(Aggregate(DC,type,weight_DC));
+        aggregates_stale=true;
+        footer_changed();
+        return aggregates.size()-1;
+    }
+    void clear_aggregates() {
+        aggregates.clear();
+        footer_changed();
+    }
+    bool aggregate(const int i,double &out) { // false => no values
+        update_aggregates();
+        return aggregates[i].result(out);
+    }
+    void show_footer(const bool show) { // pinned row under the cells with the first aggregate of each column
+        if (footer==show) return;
+        footer=show;
+        if (show) { // see handle()
+            footer_callback=callback();
+            callback(footer_row_filter); // user_data() unchanged for the callback
+        } else if (callback()==footer_row_filter) callback(footer_callback);
+        set_rows();
+        redraw();
+    }
+    void footer_changed() {
+        if (!footer) return;
+        if (update_depth || flush_scheduled) footer_dirty=true;
+        else damage(FL_DAMAGE_USER1);
+    }
+    virtual std::string aggregate_text(const Aggregate &a,const double v) { // footer text
+        char buf[64];
+        if (a.type==AGGREGATE_COUNT) snprintf(buf,sizeof(buf),"%lld",(long long)a.count);
+        else columns[a.DC]->format_number(v,buf,sizeof(buf)); // from the column format, also with a DataSource
+        return buf;
+    }
+    void draw_footer() {
+        if (!footer || row_headers.size()==0 || cols()==0) return;
+        update_aggregates();
+        const int H=default_row_height,Y=tiy+tih-H;
+        if (H>tih) return;
+        fl_push_clip(wix,Y,wiw,H);
+        if (row_header()) draw_header(footer_label.c_str(),FL_ALIGN_CENTER,tix-row_header_width(),Y,row_header_width(),H);
+        fl_push_clip(tix,Y,tiw,H);
+        fl_font(default_textfont|FL_BOLD,default_textsize);
+        for (int C=leftcol;C<=rightcol && C<cols();C++) {
+            int X,cy,W,ch;
+            if (find_cell(CONTEXT_CELL,toprow,C,X,cy,W,ch)<0) continue;
+            fl_color(FL_LIGHT2); fl_rectf(X,Y,W,H);
+            fl_color(color()); fl_rect(X,Y,W,H);
+            const int DC=column_headers.view2idx(C);
+            for (auto &a : aggregates) {
+                if (a.DC!=DC) continue;
+                double v;
+                if (a.result(v)) {
+                    fl_color(FL_GRAY0);
+                    fl_draw(aggregate_text(a,v).c_str(),X,Y,W,H,column_headers.headers[DC]->column_data_align);
+                }
+                break;
+            }
+        }
+        fl_pop_clip();
+        fl_pop_clip();
+    }
+
+
+    static void csv_write(std::FILE *f,const char *text,const CsvOptions &options) {
+        if (!options.quotes || (!strpbrk(text,"\"\r\n") && !strchr(text,options.separator))) {
+            fputs(text,f);
+            return;
+        }
+        fputc('"',f);
+        for (const char *p=text;*p;p++) {
+            if (*p=='"') fputc('"',f);
+            fputc(*p,f);
+        }
+        fputc('"',f);
+    }
+    std::string export_csv(const std::string &path,const CsvOptions &options=CsvOptions()) {
+        std::vector<char> buffer(1<<20); // outlives fclose()
+        std::FILE *f=fopen(path.c_str(),"w");
+        if (!f) return "could not open "+path+": "+strerror(errno);
+        setvbuf(f,buffer.data(),_IOFBF,buffer.size());
+        std::string err=export_csv(f,options);
+        if (fclose(f) && err.empty()) err=std::string("could not write ")+path+": "+strerror(errno);
+        return err;
+    }
+    std::string export_csv(std::FILE *f,const CsvOptions &options=CsvOptions()) { // visible rows and columns in screen order, f is flushed
+        std::vector<int> DCs;
+        for (int C=0;C<column_headers.size();C++) 
+            DCs.push_back(column_headers.view2idx(C));
+        if (options.header_row) {
+            for (size_t i=0;i<DCs.size();i++) {
+                if (i) fputc(options.separator,f);
+                csv_write(f,column_headers.headers[DCs[i]]->name.c_str(),options);
+            }
+            fputc('\n',f);
+        }
+        std::string tmp;
+        const std::vector<int> order= row_headers.indexed ? row_headers.view.to_vector() : std::vector<int>();
+        const int n=row_headers.size();
+        for (int R=0;R<n;R++) {
+            const int DR= row_headers.indexed ? order[R] : R;
+            for (size_t i=0;i<DCs.size();i++) {
+                if (i) fputc(options.separator,f);
+                if (source) csv_write(f,source->text_ptr(DR,DCs[i],tmp),options);
+                else csv_write(f,columns[DCs[i]]->text_ptr(DR,tmp),options);
+            }
+            fputc('\n',f);
+        }
+        if (fflush(f)!=0 || ferror(f)) return std::string("could not write: ")+strerror(errno);
+        return std::string();
+    }
+
+    virtual void save_view(StateView &v,const std::vector<int> &new_DR) override {
+        TableData::save_view(v,new_DR);
+        for (int C=0;C<(int)v.widths.size();C++) v.widths[C]=col_width(C);
+        v.header_width=row_header_width();
+        v.row_height=default_row_height;
+    }
+    virtual void load_view(const StateView &v) override {
+        TableData::load_view(v);
+        if (v.row_height>0) default_row_height=v.row_height;
+        set_cols();
+        set_rows();
+        for (size_t C=0;C<v.widths.size();C++) 
+            if (v.widths[C]>0) col_width(C,v.widths[C]);
+        if (v.header_width>0) row_header_width(v.header_width);
+    }
+
+    void draw_sort_indicator(const int DC,int X,int Y,int W,int H) {
+        for (size_t k=0;k<sort_keys.size();k++) {
+            if (sort_keys[k].DC!=DC) continue;
+            const int s=std::min(H/3,6),x=X+W-s-4,y=Y+(H-s)/2;
+            fl_color(k ? FL_DARK3 : FL_BLACK); // secondary keys lighter
+            if (sort_keys[k].ascending) fl_polygon(x,y+s,x+s,y+s,x+s/2,y);
+            else fl_polygon(x,y,x+s,y,x+s/2,y+s);
+        }
+    }
+
+    virtual int handle(int e) {
+        if (e==FL_PUSH && sort_on_header_click && Fl::event_button()==FL_LEFT_MOUSE) {
+            int R,C;
+            ResizeFlag resize_flag;
+            if (cursor2rowcol(R,C,resize_flag)==CONTEXT_COL_HEADER && resize_flag==RESIZE_NONE) {
+                const int DC=column_headers.view2idx(C);
+                if (DC>=0) toggle_sort(DC,Fl::event_state(FL_SHIFT)!=0);
+            }
+        }
+        if (!footer) return Fl_Table::handle(e);
+        // the empty row under the footer is only room to scroll: while the footer is shown the callback is
+        // footer_row_filter(), which drops Fl_Table's callbacks for that row and calls the table's own one in
+        // footer_callback. the row is taken out of the selection again
+        if (callback()!=footer_row_filter) { // callback() set since show_footer() => filter that one
+            footer_callback=callback();
+            callback(footer_row_filter);
+        }
+        const int ret=Fl_Table::handle(e);
+        int R1,C1,R2,C2;
+        get_selection(R1,C1,R2,C2);
+        const int last=row_headers.size()-1;
+        if (R2>last) {
+            if (R1>last) set_selection(-1,-1,-1,-1);
+            else set_selection(R1,C1,last,C2);
+        }
+        return ret;
+    }
+    Fl_Callback *footer_callback=NULL; // the table's callback while the footer is shown
+    static void footer_row_filter(Fl_Widget *w,void *data) {
+        StringTable &t=*(StringTable*)w;
+        const TableContext context=t.callback_context();
+        if ((context==CONTEXT_CELL || context==CONTEXT_ROW_HEADER) && t.callback_row()>=t.row_headers.size()) return;
+        if (t.footer_callback) t.footer_callback(w,data);
+    }
+
     virtual void draw_column_header(Header &header,int X,int Y,int W,int H) { header.draw(X,Y,W,H); }
     virtual void draw_row_header(Header &header,int X,int Y,int W,int H) { header.draw(X,Y,W,H); }
-    virtual void draw_cell(int DR,int DC,int R,int C,int X,int Y,int W,int H) { cell(DR,DC)->draw(*this,DR,DC,R,C,X,Y,W,H); }
+    virtual void draw_cell(int DR,int DC,int R,int C,int X,int Y,int W,int H) { 
+        if (source && owns(columns[DC])) { // else a column lent by a TableModel, drawn like a stored one
+            QueuedCell &q=queue_cell(DR,DC,R,C,X,Y,W,H);
+            q.text=source->text_ptr(DR,DC,q.tmp);
+            q.width=measure_text(q.text);
+            if (q.text==q.tmp.c_str()) q.text=NULL; // tmp may move when queued grows
+        } else if (columns[DC]->plain_text()) {
+            Column &column=*columns[DC];
+            QueuedCell &q=queue_cell(DR,DC,R,C,X,Y,W,H);
+            q.text=column.text_ptr(DR,q.tmp);
+            if (q.text==q.tmp.c_str()) q.text=NULL; // tmp may move when queued grows
+            q.width=column.text_width(*this,DR);
+        } else {
+            flush_queued(); // drawn by the column itself
+            columns[DC]->draw(*this,DR,DC,R,C,X,Y,W,H); 
+        }
+    }
+    void draw_source_column_header(Header &header,int DC,int X,int Y,int W,int H) {
+        const std::string label=source->column_header_text(DC);
+        if (label.empty()) draw_column_header(header,X,Y,W,H);
+        else draw_header(label.c_str(),header.column_header_align,X,Y,W,H);
+    }
 
     void draw_cell(TableContext context,int R=0,int C=0,int X=0,int Y=0,int W=0,int H=0) {
-        int DR=row_headers.view2idx(R);
-        int DC=column_headers.view2idx(C);
+        if (context==CONTEXT_STARTPAGE) { begin_frame(); return; }
+        if (queued_count && context!=CONTEXT_CELL) { // end of the cell area
+            fl_push_clip(tix,tiy,tiw,tih);
+            flush_queued();
+            fl_pop_clip();
+        }
+        const int DR= context==CONTEXT_COL_HEADER ? 0 : frame_DR(R);
+        const int DC= context==CONTEXT_ROW_HEADER ? 0 : frame_DC(C);
+        if (DR<0 && (context==CONTEXT_CELL || context==CONTEXT_ROW_HEADER)) { // row under the footer
+            fl_color(color()); fl_rectf(X,Y,W,H);
+            return;
+        }
         if (DR<0 || DC<0) return;
 
         switch(context) {
-            case CONTEXT_STARTPAGE: fl_font(default_textfont,default_textsize); break;
-            case CONTEXT_COL_HEADER: draw_column_header(*column_headers.headers[DC],X,Y,W,H); break;
-            case CONTEXT_ROW_HEADER: draw_row_header(*row_headers.headers[DR],X,Y,W,H); break;
+            case CONTEXT_COL_HEADER: 
+                if (source) draw_source_column_header(*column_headers.headers[DC],DC,X,Y,W,H);
+                else draw_column_header(*column_headers.headers[DC],X,Y,W,H); 
+                if (!sort_keys.empty()) draw_sort_indicator(DC,X,Y,W,H);
+                break;
+            case CONTEXT_ROW_HEADER: 
+                if (source) draw_header(source->row_header_text(DR).c_str(),FL_ALIGN_CENTER,X,Y,W,H);
+                else draw_row_header(*row_headers.headers[DR],X,Y,W,H); 
+                break;
             case CONTEXT_CELL: draw_cell(DR,DC,R,C,X,Y,W,H); break;
             case CONTEXT_RC_RESIZE: break;
             default: break;
         }
     }
 
+    virtual void draw() override {
+        if (damage()==FL_DAMAGE_USER1) { // only the totals changed
+            draw_footer();
+            return;
+        }
+        Fl_Table::draw();
+        draw_footer(); // over whatever rows are under it
+    }
+
     int default_row_height=14;
     Fl_Font default_textfont=FL_HELVETICA;
     int default_textsize=12;
@@ -344,7 +3271,138 @@ struct StringTable : public Fl_Table {
         remove_row("row3");
     }
 
-    virtual ~StringTable() { clear(); }
+    virtual ~StringTable() { 
+        Fl::remove_timeout(flush_cb,this);
+        clear_flashes();
+        clear(); 
+    }
+};
+
+inline void TableData::TextCell::draw(StringTable &table,int DR,int DC,int R,int C,int X,int Y,int W,int H) {
+    fl_push_clip(X,Y,W,H);
+    fl_color(table.cell_background(DR,DC,R,C)); fl_rectf(X,Y,W,H); // selection looked up once per redraw
+    fl_color(FL_GRAY0); fl_draw(_text.c_str(),X,Y,W,H,column_header.column_data_align);
+    fl_color(table.color()); fl_rect(X,Y,W,H);
+    fl_pop_clip();
+}
+inline void TableData::Column::ProxyCell::draw(StringTable &table,int DR,int DC,int R,int C,int X,int Y,int W,int H) { column.draw(table,DR,DC,R,C,X,Y,W,H); }
+inline void TableData::CellColumn::draw(TableData &view,int DR,int DC,int R,int C,int X,int Y,int W,int H) { cells[DR]->draw(static_cast<StringTable&>(view),DR,DC,R,C,X,Y,W,H); }
+
+// rows and cells stored once and shown by any number of StringTable views, each with its own column
+// order, sort, filters, aggregates and flashes. the model is a TableData without a widget, so everything
+// that fills a table (add_row()/setText(), typed and dictionary columns, upsert(), apply_snapshot(),
+// import_csv(), load_state()...) is done on it. views read it as their DataSource and are told about
+// every change, so one update damages just that cell in each view showing it. begin_update()/end_update()
+// batch the damage of every view.
+// columns belong to the model: views get all of them with the same DCs and choose their own column view.
+// a view draws the model's Column objects, so sparklines and cell_factory() cells look the same in it
+class TableModel : public TableData,public StringTable::DataSource {
+    std::vector<StringTable*> views;
+
+    void share_column(StringTable &view,const int DC) {
+        view.column_headers.headers[DC]->column_format=column_headers.headers[DC]->column_format;
+        Column *&column=view.columns[DC];
+        if (column==columns[DC]) return;
+        if (view.owns(column)) view.delete_column(column);
+        column=columns[DC];
+    }
+    void sync_columns(StringTable &view) {
+        for (int DC=(int)view.columns.size()-1;DC>=0;DC--) {
+            const std::string name=view.column_headers.headers[DC]->name;
+            if (column_headers.get_idx(name)<0) view.remove_column(name,false);
+        }
+        for (size_t DC=0;DC<view.columns.size();DC++) { // columns added to the view itself => start again
+            if (view.column_headers.headers[DC]->name==column_headers.headers[DC]->name) continue;
+            while (!view.columns.empty()) view.remove_column(view.column_headers.headers.back()->name,false);
+            break;
+        }
+        for (size_t DC=view.columns.size();DC<columns.size();DC++) {
+            const Header &h=*column_headers.headers[DC];
+            view.add_column(h.name,h.label,0,h.column_data_align,false);
+            view.column_headers.headers[DC]->column_header_align=h.column_header_align;
+        }
+        for (size_t DC=0;DC<columns.size();DC++) share_column(view,DC);
+        view.set_cols();
+        view.redraw();
+    }
+
+public:
+    TableModel() { 
+        row_headers.clear_view(); // views keep their own row order
+    }
+    virtual ~TableModel() {
+        while (!views.empty()) views.back()->set_source(NULL);
+        clear();
+    }
+
+    TableData &data() { return *this; } // add columns and rows, update cells here
+    void attach(StringTable &view) { // view shows the model from now on, its own rows and columns are dropped
+        view.clear();
+        view.set_source(this);
+        views.push_back(&view);
+        sync_columns(view);
+        view.source_rows_rebuilt();
+        for (int i=0;i<update_depth;i++) view.begin_update(); // attached during a batch
+    }
+    void detach(StringTable &view) { if (view.source==this) view.set_source(NULL); }
+
+    // DataSource for the views
+    virtual int row_count() override { return row_headers.slot_count(); }
+    virtual std::string text(int DR,int DC) override { return columns[DC]->text(DR); }
+    virtual std::string row_header_text(int DR) override { return row_headers.headers[DR]->label; }
+    virtual bool row_exists(int DR) override { return DR>=0 && DR<row_headers.slot_count() && row_headers.headers[DR]; }
+    virtual const char *text_ptr(int DR,int DC,std::string &tmp) override { return columns[DC]->text_ptr(DR,tmp); }
+    virtual bool number(int DR,int DC,double &out) override { return columns[DC]->number(DR,out); }
+    virtual int compare(int DR1,int DR2,int DC) override { return columns[DC]->compare(DR1,DR2); }
+    virtual void detached(StringTable &view) override { 
+        views.erase(std::remove(views.begin(),views.end(),&view),views.end()); 
+        for (int i=0;i<update_depth;i++) view.end_update(); // detached during a batch
+    }
+
+    // changes of the data => every view
+    virtual bool wants_direction() override {
+        for (auto v : views) 
+            if (v->wants_direction()) return true;
+        return false;
+    }
+    virtual void cell_stored(int DR,int DC,int direction) override {
+        for (auto v : views) v->cell_stored(DR,DC,direction);
+    }
+    virtual void row_updated(int DR,int DC) override {
+        for (auto v : views) v->row_updated(DR,DC);
+    }
+    virtual void rows_updated(const std::vector<int> &DRs) override {
+        for (auto v : views) v->rows_updated(DRs);
+    }
+    virtual void row_added(int DR) override {
+        for (auto v : views) v->source_row_added(DR);
+    }
+    virtual void row_removing(int DR) override {
+        for (auto v : views) v->source_row_removed(DR);
+    }
+    virtual void rows_cleared() override { rows_rebuilt(); }
+    virtual void rows_renumbered() override { rows_rebuilt(); }
+    virtual void rows_rebuilt() override {
+        for (auto v : views) v->source_rows_rebuilt();
+    }
+    virtual void column_added(int DC) override { column_count_changed(); }
+    virtual void column_removed(int DC) override { column_count_changed(); }
+    virtual void columns_cleared() override { column_count_changed(); }
+    virtual void column_count_changed() override {
+        for (auto v : views) sync_columns(*v);
+    }
+    virtual void column_changed(int DC,bool retyped) override {
+        for (auto v : views) {
+            share_column(*v,DC);
+            v->column_changed(DC,retyped);
+        }
+    }
+    virtual void update_begun() override { // a batch on the data is a batch on every view => one damage flush each
+        for (auto v : views) v->begin_update();
+    }
+    virtual void update_ended() override {
+        for (auto v : views) v->end_update();
+    }
 };
 
 } // namespace fltklayout
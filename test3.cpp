@@ -3,24 +3,6 @@
 
 #include <iostream>
 
-Fl_Widget *clone(fltklayout::Widgets &widgets,fltklayout::Factories &factories,Fl_Widget *o,const std::string &new_widget_name) {
-
-    fltklayout::WidgetInfo *i=widgets.get_info(o);
-    if (!i) return NULL; // cant find metadata
-
-    // metadata provides factory we can use to create a new instance
-    Fl_Widget *n=i->factory->create(&widgets,new_widget_name,0,0,1,1,"");
-
-    // then we duplicate all the properties
-    fltklayout::PropertyMap props=widgets.get_properties(o);
-    for (const auto &p : props) {
-        if (p.first!="name" && p.first!="parent") // prevent duplicating name or moving to group
-            i->factory->set_property(&widgets,n,p.first,p.second);
-    }
-
-    return n;
-}
-
 struct MyWindow : public Fl_Double_Window {
     fltklayout::Widgets widgets;      // collection of managed widgets in this window (indexed by name and Fl_Widget*)
     fltklayout::Factories factories;  // collection of 'factories' for widget descriptions (indexed by factory name)
@@ -45,8 +27,8 @@ struct MyWindow : public Fl_Double_Window {
             std::cout << "Button1 pressed!" << std::endl;
         };
 
-        // clone first button
-        b2=clone(widgets,factories,b1,"button2");
+        // clone first button (copies properties directly, deep clones children of groups)
+        b2=widgets.clone(b1,"button2");
         b2->resize(50,100,100,50);
 
         // set callback (callback was not cloned)